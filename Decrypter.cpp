@@ -1,220 +1,2040 @@
 #include "provided.h"
+#include "ResultCache.h"
+#include "QuadgramSolver.h"
 #include <string>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <utility>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <queue>
+#include <functional>
 
 using namespace std;
 
 const string SEPARATORS = "0123456789 ,;:.!()[]{}-\"#$%^&";
 
+// Memory the result cache may use unless setCacheBudget says otherwise
+const size_t DEFAULT_CACHE_BUDGET = 32 << 20;
+
+// In a parallel crack, the children of search nodes this close to the root can be handed to idle threads.
+// Deeper subtrees are too small to be worth replaying on another thread
+const int MAX_SPLIT_DEPTH = 4;
+
+// Number of search nodes a thread expands between looks at the clock, the cancel flag and the shared node count
+const int LIMIT_CHECK_INTERVAL = 256;
+
+// Domain of a cipher letter that could still be any plaintext letter
+const unsigned int ALL_LETTERS = (1u << 26) - 1;
+
+// Words with more candidates than this under the mapping so far don't narrow the letter domains, since checking
+// every candidate against the domains would cost more than it saves
+const int MAX_SUPPORT_SCAN = 64;
+
+// Every search remembers up to 2^NOGOOD_TABLE_BITS states that turned out to have no solutions
+const int NOGOOD_TABLE_BITS = 16;
+
+// Statistics are compiled in unless DECRYPTER_NO_STATS is defined.  STATS runs a statement only while the search is
+// collecting them, and STATS_TIMER adds the time until the end of the enclosing block to a phase total
+#ifndef DECRYPTER_NO_STATS
+#define DECRYPTER_STATS 1
+#define STATS(statement) do { if (m_collect){ statement; } } while (false)
+#define STATS_TIMER(total) PhaseTimer phaseTimer(m_collect ? &(total) : nullptr)
+#else
+#define STATS(statement) do {} while (false)
+#define STATS_TIMER(total) do {} while (false)
+#endif
+
+
+// Everything about one ciphertext that the search needs, built once per crack and only read while searching, so any
+// number of threads can share it.
+// The search works on each distinct cipher word (upper case) once, distinctWords, since a repeated word adds nothing
+// to the search; wordCounts[w] is how many times word w appears in the message.  letterWords[c] holds the indexes of
+// the distinct words containing cipher letter c, unknownCount[w] how many distinct letters word w has, and nUnmapped
+// how many distinct letters the whole message has, which are listed in letters
+struct CrackProblem
+{
+    const WordList* wl;
+    string message;
+    vector<string> distinctWords;
+    vector<int> wordCounts;
+    vector<int> letterWords[26];
+    vector<int> letters;
+    vector<int> unknownCount;
+    int nUnmapped;
+};
+
+
+// Adds the time it's alive to a total, unless the total is nullptr
+class PhaseTimer
+{
+public:
+    PhaseTimer(double* total);
+    ~PhaseTimer();
+
+    // PhaseTimer objects cannot be copied or assigned
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    double* m_total;
+    chrono::steady_clock::time_point m_start;
+};
+
+
+// A subtree of the search, given by the choices of (distinct word, candidate) that lead to it from the root
+struct SearchTask
+{
+    vector<pair<int, string>> path;
+};
+
+
+// Where every solution of a crack goes.  The callback is only ever called by one thread at a time.  Once it asks to
+// stop, or a limit is reached, every search sees stopped() and unwinds, and status() says why.  A sink without a
+// callback only counts solutions, so the searches never build their plaintext and just report how many they found
+class SolutionSink
+{
+public:
+    SolutionSink(const SolutionCallback* onSolution, bool shared);
+    bool add(const string& solution);
+    void addCount(long long nFound);
+    void stop(CrackStatus reason);
+    bool countOnly() const;
+    bool stopped() const;
+    CrackStatus status() const;
+    long long count() const;
+
+private:
+    const SolutionCallback* m_onSolution;
+    bool m_shared;              // Whether several threads add solutions, so the callback needs locking
+    mutex m_lock;
+    atomic<int> m_status;       // The CrackStatus, Complete until something stops the search
+    atomic<long long> m_count;
+};
+
+
+// The deadline, node budget and cancel flag of a crack, shared by all its searches.  Each search counts its own nodes
+// and only reports them every LIMIT_CHECK_INTERVAL nodes (or sooner, close to the budget), so the checks cost next to
+// nothing per node
+class SearchLimits
+{
+public:
+    SearchLimits(const CrackOptions& options);
+    bool any() const;
+    long long check(long long newNodes, SolutionSink& sink);
+
+private:
+    chrono::steady_clock::time_point m_deadline;
+    long long m_maxNodes;
+    const atomic<bool>* m_cancel;
+    atomic<long long> m_nodes;      // Nodes reported by every search so far
+};
+
+
+// Puts the solutions of a streaming crack in order.  Solutions are buffered until they use sortBufferBytes, then
+// sorted and written out to a temporary file as one run.  Once the search finishes the runs are merged, so only the
+// head of every run has to be in memory.  If everything fits in the buffer no file is ever written
+class SortedSolutions
+{
+public:
+    SortedSolutions(size_t bufferBytes);
+    ~SortedSolutions();
+    bool add(const string& solution);
+    bool deliver(const SolutionCallback& onSolution);
+    bool failed() const { return m_failed; }
+
+    // SortedSolutions objects cannot be copied or assigned
+    SortedSolutions(const SortedSolutions&) = delete;
+    SortedSolutions& operator=(const SortedSolutions&) = delete;
+
+private:
+    size_t m_bufferBytes;
+    size_t m_usedBytes;
+    vector<string> m_buffer;
+    vector<FILE*> m_runs;
+    bool m_failed;              // A run couldn't be written
+
+    bool spill();
+    static bool readRecord(FILE* f, string& s);
+};
+
+
+// Work-stealing scheduler for a parallel crack.  Every thread has its own deque of tasks: it pushes and pops its own
+// tasks at the back, so it keeps working on the subtree it just split, while idle threads steal from the front, where
+// the biggest (closest to the root) subtrees are
+class TaskPool
+{
+public:
+    TaskPool(int nThreads);
+    void push(int thread, SearchTask task);
+    bool next(int thread, SearchTask& task);
+    void finished();
+    bool hungry() const;
+
+private:
+    struct TaskDeque
+    {
+        mutex lock;
+        deque<SearchTask> tasks;
+    };
+
+    vector<unique_ptr<TaskDeque>> m_deques;
+    atomic<int> m_pending;      // Tasks pushed but not yet finished
+    atomic<int> m_idle;         // Threads currently looking for work
+
+    bool popBack(int thread, SearchTask& task);
+    bool stealFront(int thread, SearchTask& task);
+};
+
+
+// One thread's search.  Each search has its own Translator and its own count of the letters still unknown, and reads
+// the shared CrackProblem and WordList
+class CrackSearch
+{
+public:
+    CrackSearch(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, TaskPool* pool, int thread,
+                bool collectStats);
+    void run(const SearchTask& task);
+    const CrackStats& stats() const;
+
+    // CrackSearch objects cannot be copied or assigned
+    CrackSearch(const CrackSearch&) = delete;
+    CrackSearch& operator=(const CrackSearch&) = delete;
+
+private:
+    // The cipher letters one choice mapped for the first time, and the domains from before it if it narrowed them
+    struct Choice
+    {
+        unsigned char letters[26];
+        int nLetters;
+        bool narrowed;
+        unsigned int domains[26];
+    };
+
+    const CrackProblem& m_problem;
+    SolutionSink& m_sink;
+    SearchLimits& m_limits;
+    TaskPool* m_pool;       // nullptr for a sequential crack
+    int m_thread;
+    Translator m_translator;
+
+    // unknownCount and nUnmapped of the CrackProblem, less the letters mapped so far, so that only the words a new
+    // mapping completes need checking
+    vector<int> m_unknownCount;
+    int m_nUnmapped;
+
+    // Bit p of m_domains[c] is set while cipher letter c could still be plaintext letter p, given the choices so far
+    // and the candidates of every word.  m_candidateCounts[w] is how many candidates word w has with those domains
+    unsigned int m_domains[26];
+    vector<int> m_candidateCounts;
+
+    // States known to lead to no solution, found by hashing the part of the state the rest of the search depends on.
+    // Two independent 64-bit hashes make a false match, which would lose solutions, too unlikely to matter.
+    // Only allocated once the first one is found
+    struct Nogood
+    {
+        unsigned long long key;     // 0 for an empty slot
+        unsigned long long check;
+    };
+    vector<Nogood> m_nogoods;
+    vector<unsigned int> m_wordLetters; // Cipher letters of every distinct word
+    long long m_nSolutions;             // Solutions found by this search, to tell whether a subtree had any
+    long long m_nSplits;                // Tasks handed to the pool, whose subtrees this search never sees
+
+    vector<pair<int, string>> m_path;   // Choices leading to the current node, kept only when there is a pool
+    long long m_nFound;                 // Solutions found by a counting search since the last task began
+
+    // Nodes this search will expand before it next checks the limits, or -1 if the crack has none
+    long long m_nodesToCheck;
+    long long m_unreported;             // Nodes not yet reported to the limits
+
+    // This thread's statistics, kept without any locking and only while m_collect is set
+    bool m_collect;
+    CrackStats m_stats;
+    int m_depth;                        // Words chosen on the path to the current node
+
+    void decryptWords(vector<int> remaining);
+    void solutionFound();
+    bool withinLimits();
+    int fewestCandidatesIndex(const vector<int>& remaining);
+    bool choose(int w, const string& candidate, Choice& choice);
+    void unchoose(const Choice& choice);
+    bool mapLetters(const unsigned char* letters, int n);
+    void unmapLetters(const unsigned char* letters, int n);
+    bool propagate();
+    bool removeTakenLetters(bool& changed);
+    void stateKey(const vector<int>& remaining, unsigned long long& key, unsigned long long& check) const;
+    bool isNogood(unsigned long long key, unsigned long long check) const;
+    void addNogood(unsigned long long key, unsigned long long check);
+    static unsigned long long mix(unsigned long long x);
+};
+
+
+// Best-first search for the most likely solutions, for crackBest.  Every state of the search is a partial mapping,
+// scored by the log probability of the words it has fully translated.  The states wait in a priority queue ordered by
+// that score plus, for every word not fully translated yet, the log probability of the likeliest word in the list with
+// its letter pattern.  That can only overestimate what the state will score once complete, so complete states come out
+// of the queue in order of score, most likely first, and the search stops once it has enough of them
+class BestFirstSearch
+{
+public:
+    BestFirstSearch(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, int beamWidth);
+    void run(int k, vector<ScoredSolution>& solutions);
+
+private:
+    struct State
+    {
+        unsigned char mapping[26];  // Upper case plaintext letter of every cipher letter, 0 if it has no mapping yet
+        unsigned int mapped;        // Bit c set if cipher letter c has a mapping
+        double score;               // Log probability of the fully translated words
+        double bound;               // score plus the best the other words could do
+    };
+
+    const CrackProblem& m_problem;
+    SolutionSink& m_sink;
+    SearchLimits& m_limits;
+    int m_beamWidth;                    // Most states kept waiting, 0 for no limit
+
+    vector<unsigned int> m_letterMask;  // Cipher letters of every distinct word
+    vector<double> m_bestLogProb;       // Log probability of the likeliest word with every distinct word's pattern
+    unsigned int m_allLetters;          // Every cipher letter of the message
+    vector<State> m_queue;              // Heap of states, highest bound first
+
+    static bool lowerBound(const State& a, const State& b);
+    void buildTranslator(const State& state, Translator& translator) const;
+    void expand(const State& state);
+    void push(const State& state);
+};
+
+
+// Cracking only reads the word list and the tokenizer, so any number of cracks can run at once on one DecrypterImpl,
+// and any number of DecrypterImpls can share one word list
 class DecrypterImpl
 {
 public:
     DecrypterImpl();
+    DecrypterImpl(shared_ptr<const WordList> wordList);
     ~DecrypterImpl();
     bool load(string filename);
-    vector<string> crack(const string& ciphertext);
+    vector<string> crack(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const;
+    CrackStatus crack(const string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options) const;
+    long long crackCount(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const;
+    vector<string> crackFirst(const string& ciphertext, int n, const CrackOptions& options, CrackStatus* status) const;
+    vector<ScoredSolution> crackBest(const string& ciphertext, int k, const CrackOptions& options, CrackStatus* status) const;
+    ScoredSolution crackQuadgram(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const;
+    void crackBatch(const function<bool(string&)>& nextCiphertext, const function<void(BatchResult&)>& onResult,
+                    const CrackOptions& options, int workers) const;
+    vector<BatchResult> crackBatch(const vector<string>& ciphertexts, const CrackOptions& options, int workers) const;
+    void setCacheBudget(size_t bytes);
+    CacheStats cacheStats() const;
+    void setCollectStats(bool collect);
+    CrackStats stats() const;
+    void resetStats();
 private:
-    WordList* m_wl;
-    Translator* m_translator;
+    shared_ptr<const WordList> m_wl;
     Tokenizer* m_tokenizer;
-    
-    void decryptWords(vector<string> cipherWords, vector<string>& solutions, const string& message);
-    int largestUnknownIndex(const vector<string>& cipherwords) const;
-    bool possibleTranslation(const vector<string>& translatedWords, bool& solution);
-    
+    mutable ResultCache m_cache;    // Shared by every crack, it locks itself
+
+    // Every search adds its statistics once it's done, so the lock is only taken once per crack
+    atomic<bool> m_collectStats;
+    mutable mutex m_statsLock;
+    mutable CrackStats m_stats;
+
+    shared_ptr<const vector<string>> cachedSolutions(const string& ciphertext, const CrackOptions& options, string& key) const;
+    static CrackStatus deliverCached(const vector<string>& solutions, const SolutionCallback& onSolution);
+    CrackStatus crackUncached(const string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options) const;
+
+    static int threadCount(const CrackOptions& options);
+    CrackStatus search(const string& ciphertext, SolutionSink& sink, const CrackOptions& options, int nThreads) const;
+    bool prepareProblem(const string& ciphertext, const vector<string_view>& cipherWords, CrackProblem& problem) const;
+    void searchParallel(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, int nThreads,
+                        bool collectStats, CrackStats& stats) const;
+    bool collectingStats() const;
+    void addStats(const CrackStats& stats) const;
+    static void addStats(CrackStats& total, const CrackStats& stats);
 };
 
 DecrypterImpl::DecrypterImpl()
-: m_wl(new WordList), m_translator(new Translator), m_tokenizer(new Tokenizer(SEPARATORS)){}
+: m_wl(new WordList), m_tokenizer(new Tokenizer(SEPARATORS)), m_cache(DEFAULT_CACHE_BUDGET), m_collectStats(false){}
+
+DecrypterImpl::DecrypterImpl(shared_ptr<const WordList> wordList)
+: m_wl(wordList), m_tokenizer(new Tokenizer(SEPARATORS)), m_cache(DEFAULT_CACHE_BUDGET), m_collectStats(false)
+{
+    if (m_wl == nullptr){
+        // Crack against an empty list rather than crash
+        m_wl.reset(new WordList);
+    }
+}
 
 DecrypterImpl::~DecrypterImpl()
 {
-    delete m_wl;
-    delete m_translator;
     delete m_tokenizer;
 }
 
 bool DecrypterImpl::load(string filename)
 {
-    // The loadWordList() function first discards any old list of words, then returns true if it can load the words,
+    // Load into a new list rather than the current one, which other Decrypters may be sharing.
+    // The old list is discarded either way, like loadWordList() does, then returns true if it can load the words,
     // false otherwise
-    return m_wl->loadWordList(filename);
+    shared_ptr<WordList> wl(new WordList);
+    bool collect = collectingStats();
+    CrackStats stats;
+    bool loaded;
+    {
+        PhaseTimer timer(collect ? &stats.loadSeconds : nullptr);
+        loaded = wl->loadWordList(filename);
+    }
+    m_wl = wl;
+    if (collect){
+        addStats(stats);
+    }
+
+    // Results found with the old list no longer hold
+    m_cache.clear();
+    return loaded;
 }
 
-vector<string> DecrypterImpl::crack(const string& ciphertext)
+vector<string> DecrypterImpl::crack(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const
 {
-    // Break up the message into the words
-    vector<string> cipherWords = m_tokenizer->tokenize(ciphertext);
-    
+    // The same message up to the key of the cipher may have been cracked already
+    string key;
+    shared_ptr<const vector<string>> cached = cachedSolutions(ciphertext, options, key);
+    if (cached != nullptr){
+        if (status != nullptr){
+            *status = CrackStatus::Complete;
+        }
+        return *cached;
+    }
+
+    // Collect every solution
     vector<string> solutions;   // To hold all possible solutions
-    
-    // If there are only separators (or empty string), just return the message
-    if (cipherWords.size() == 0){
-        solutions.push_back(ciphertext);
-        return solutions;
+    CrackOptions unsorted = options;
+    unsorted.sorted = false;
+    CrackStatus result = crackUncached(ciphertext, [&solutions](const string& solution){
+        solutions.push_back(solution);
+        return true;
+    }, unsorted);
+    if (status != nullptr){
+        *status = result;
     }
-    
-    // Call recursive function to find all possible solutions
-    decryptWords(cipherWords, solutions, ciphertext);
-    
+
     // Put in alphabetical order
     sort(solutions.begin(), solutions.end());
-    
+
+    // Only a search that ran to the end has all the solutions
+    if ( ! key.empty() && result == CrackStatus::Complete){
+        m_cache.insert(key, solutions);
+    }
+
     return solutions;  // Return all possible solutions
 }
 
 
-void DecrypterImpl::decryptWords(vector<string> cipherWords, vector<string>& solutions, const string& message)
+CrackStatus DecrypterImpl::crack(const string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options) const
 {
-    // Step 2
-    // Choose the word with the largest number of unknown letters and erase it from the words that haven't been chosen
-    int index = largestUnknownIndex(cipherWords);
-    string current = cipherWords[index];
-    cipherWords.erase(cipherWords.begin() + index);
-    
-    // Step 3
-    // Translate the current word with the current mapping
-    string translation = m_translator->getTranslation(current);
-    
-    // Step 4
-    // Find all possible words that match the cipher pattern and the partial translation
-    vector<string> candidates = m_wl->findCandidates(current, translation);
-    
-    // Step 5
-    // If there are no possible candidates, return to previous call
-    int nCandidates = (int)candidates.size();
-    if (nCandidates == 0){
-        return;
+    // A cached result is delivered in alphabetical order, which is fine whether or not order was asked for
+    string key;
+    shared_ptr<const vector<string>> cached = cachedSolutions(ciphertext, options, key);
+    if (cached != nullptr){
+        return deliverCached(*cached, onSolution);
     }
-    
-    // Step 6
-    for (int i = 0; i < nCandidates; i++){
-        // For every candidate word
-        
-        // part a
-        // Try to add a new mapping based on the current candidate word
-        if ( ! m_translator->pushMapping(current, candidates[i])){
-            // If adding the mapping for the current word can't be done (overlapping letter mapping), move onto next word
-            continue;
+    return crackUncached(ciphertext, onSolution, options);
+}
+
+
+CrackStatus DecrypterImpl::crackUncached(const string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options) const
+{
+    // Passes every solution to onSolution as soon as it's found, until onSolution returns false or a limit is reached
+    int nThreads = threadCount(options);
+
+    if ( ! options.sorted){
+        SolutionSink sink(&onSolution, nThreads > 1);
+        return search(ciphertext, sink, options, nThreads);
+    }
+
+    // Only ordering needs every solution to be found before the first can be delivered.
+    // If the search was cut off, what it did find is still delivered.  That includes a run that couldn't be written:
+    // the search stops there, the solutions kept in memory and in the runs already written are delivered, and the
+    // status says the write failed
+    SortedSolutions sorted(options.sortBufferBytes);
+    SolutionCallback toSorted = [&sorted](const string& solution){
+        return sorted.add(solution);
+    };
+    SolutionSink sink(&toSorted, nThreads > 1);
+    CrackStatus status = search(ciphertext, sink, options, nThreads);
+    bool delivered = sorted.deliver(onSolution);
+    if (sorted.failed()){
+        status = CrackStatus::WriteFailed;
+    } else if ( ! delivered && status == CrackStatus::Complete){
+        status = CrackStatus::Stopped;
+    }
+    return status;
+}
+
+
+long long DecrypterImpl::crackCount(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const
+{
+    // A cached result already says how many there are
+    string key;
+    shared_ptr<const vector<string>> cached = cachedSolutions(ciphertext, options, key);
+    if (cached != nullptr){
+        if (status != nullptr){
+            *status = CrackStatus::Complete;
         }
-        
-        // part b
-        // Translate the whole message based on the current mapping
-        string msgTranslation = m_translator->getTranslation(message);
-        
-        // Break the now (partially) translated message into its words
-        vector<string> translatedWords = m_tokenizer->tokenize(msgTranslation);
-        bool isSolution = true;
-        
-        // part c
-        // Check all fully translated words
-        if ( ! possibleTranslation(translatedWords, isSolution)){
-            // case i
-            // A fully translated word is not in the list of words, get rid of that mapping and move to the next cadidate
-            m_translator->popMapping();
-            continue;
+        return (long long)cached->size();
+    }
+
+    // Count the solutions without ever building one
+    int nThreads = threadCount(options);
+    SolutionSink sink(nullptr, nThreads > 1);
+    CrackStatus result = search(ciphertext, sink, options, nThreads);
+    if (status != nullptr){
+        *status = result;
+    }
+    return sink.count();
+}
+
+
+vector<string> DecrypterImpl::crackFirst(const string& ciphertext, int n, const CrackOptions& options, CrackStatus* status) const
+{
+    // Stop the search once it finds solution n + 1, which is dropped.  Stopping at solution n instead would report
+    // Stopped for a message with exactly n solutions, when every one of them was found
+    vector<string> solutions;
+    if (n <= 0){
+        if (status != nullptr){
+            *status = CrackStatus::Stopped;
         }
-        
-        
-        if (isSolution){
-            // case iii
-            // If all words were fully translated and in the word list, add the message to the vector of solutions
-            // and get rid of the current mapping
-            solutions.push_back(msgTranslation);
-            m_translator->popMapping();
-        } else {
-            // case ii
-            // Otherwise, some words are not fully translated but those that are are in the map,
-            // recursively call this function, building upon the current map
-            decryptWords(cipherWords, solutions, message);
-            // Once the recursive call returns, get rid of the current mapping
-            m_translator->popMapping();
+        return solutions;
+    }
+
+    CrackOptions unsorted = options;
+    unsorted.sorted = false;
+    CrackStatus result = crack(ciphertext, [&solutions, n](const string& solution){
+        if ((int)solutions.size() == n){
+            return false;
         }
+        solutions.push_back(solution);
+        return true;
+    }, unsorted);
+    if (status != nullptr){
+        *status = result;
     }
+
+    // The solutions found first depend on the search order, but at least always list them in alphabetical order
+    sort(solutions.begin(), solutions.end());
+    return solutions;
 }
 
 
-int DecrypterImpl::largestUnknownIndex(const vector<string>& cipherWords) const
+vector<ScoredSolution> DecrypterImpl::crackBest(const string& ciphertext, int k, const CrackOptions& options, CrackStatus* status) const
 {
-    // Find the word with the largest number of untranslated letters
-    int largestIndex = 0;
-    int nWords = (int)cipherWords.size();
-    int nUnknownMax = 0;
-    for (int j = 0; j < cipherWords[0].size(); j++){
-        nUnknownMax++;
-    }
-    for (int i = 1; i < nWords; i++){
-        int nUnknownCurr = 0;
-        for (int j = 0; j < cipherWords[i].size(); j++){
-            nUnknownCurr++;
-        }
-        if (nUnknownCurr > nUnknownMax){
-            largestIndex = i;
-            nUnknownMax = nUnknownCurr;
-        }
-    }
-    
-    // Return the index of the word with the most unknown letters
-    return largestIndex;
-}
-
-bool DecrypterImpl::possibleTranslation(const vector<string>& translatedWords, bool& solution)
-{
-    int words = (int)translatedWords.size();
-    for (int j = 0; j < words; j++){
-        // For every word in the message
-        bool fullyTranslated = true;
-        string currWord = translatedWords[j];
-        for (int k = 0; k < translatedWords[j].size(); k++){
-            // For every letter in the word
-            if (currWord[k] == '?'){
-                // If part of the word isn't translated yet, we haven't reached a solution and this word is not
-                // fully translated
-                solution = false;
-                fullyTranslated = false;
-                // Move onto the next word
-                break;
-            }
-        }
-        
-        if (fullyTranslated){
-            // If the current word is fully translated
-            if ( ! m_wl->contains(currWord)){
-                // If the word is not in the list, we have not reached a solution, and return false to signify the
-                // current mapping is wrong
-                solution = false;
-                return false;
+    // Finds the k solutions whose words are likeliest together, most likely first, without going through the rest
+    vector<ScoredSolution> solutions;
+    SolutionSink sink(nullptr, false);
+    if (status != nullptr){
+        *status = CrackStatus::Complete;
+    }
+    if (k <= 0){
+        return solutions;
+    }
+
+    // Break up the message into the words, as views into the message
+    vector<string_view> cipherWords;
+    m_tokenizer->tokenize(ciphertext, cipherWords);
+
+    // If there are only separators (or empty string), the message is its only solution
+    ScoredSolution only;
+    only.solution = ciphertext;
+    only.logProb = 0;
+    if (cipherWords.size() == 0){
+        solutions.push_back(only);
+        return solutions;
+    }
+
+    CrackProblem problem;
+    if ( ! prepareProblem(ciphertext, cipherWords, problem)){
+        return solutions;
+    }
+
+    SearchLimits limits(options);
+    BestFirstSearch search(problem, sink, limits, options.beamWidth);
+    search.run(k, solutions);
+    if (status != nullptr){
+        *status = sink.status();
+    }
+    return solutions;
+}
+
+
+ScoredSolution DecrypterImpl::crackQuadgram(const string& ciphertext, const CrackOptions& options, CrackStatus* status) const
+{
+    // Score keys on the words of the message, as views into it
+    vector<string_view> cipherWords;
+    m_tokenizer->tokenize(ciphertext, cipherWords);
+
+    QuadgramSolver solver(m_wl->quadgramTable(), cipherWords);
+    unsigned char key[26];
+    ScoredSolution solution;
+    CrackStatus result = solver.solve(options, threadCount(options), key, solution.logProb);
+    if (status != nullptr){
+        *status = result;
+    }
+
+    // Translate with the whole key
+    string cipher;
+    string plain;
+    for (int c = 0; c < 26; c++){
+        cipher += (char)('A' + c);
+        plain += (char)('A' + key[c]);
+    }
+    Translator translator;
+    translator.pushMapping(cipher, plain);
+    solution.solution = translator.getTranslation(ciphertext);
+    return solution;
+}
+
+
+void DecrypterImpl::crackBatch(const function<bool(string&)>& nextCiphertext, const function<void(BatchResult&)>& onResult,
+                               const CrackOptions& options, int workers) const
+{
+    // Cracks every ciphertext nextCiphertext gives until it returns false, on a pool of worker threads that each take
+    // the next ciphertext as soon as they finish one.  Each result goes to onResult, one at a time, as soon as it's
+    // ready, so they can come back in any order; their index says which ciphertext they belong to
+    if (workers <= 0){
+        workers = max(1, (int)thread::hardware_concurrency());
+    }
+
+    mutex inputLock;
+    mutex outputLock;
+    size_t nextIndex = 0;
+    bool inputDone = false;
+
+    auto work = [&](){
+        string ciphertext;
+        BatchResult result;
+        for (;;){
+            // Take the next ciphertext
+            {
+                lock_guard<mutex> guard(inputLock);
+                if (inputDone || ! nextCiphertext(ciphertext)){
+                    inputDone = true;
+                    return;
+                }
+                result.index = nextIndex++;
             }
+
+            // Every worker searches on its own, the search state of each crack belongs to the worker alone
+            result.solutions = crack(ciphertext, options, &result.status);
+
+            lock_guard<mutex> guard(outputLock);
+            onResult(result);
         }
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < workers; t++){
+        threads.push_back(thread(work));
+    }
+    // The calling thread works too
+    work();
+    for (int t = 0; t < (int)threads.size(); t++){
+        threads[t].join();
     }
-    
-    // All fully translated words in the map are in the list, this mapping is still a possibility
-    return true;
 }
 
 
+vector<BatchResult> DecrypterImpl::crackBatch(const vector<string>& ciphertexts, const CrackOptions& options, int workers) const
+{
+    // Crack a whole vector of ciphertexts, returning the results in the same order
+    vector<BatchResult> results(ciphertexts.size());
+    size_t next = 0;
+    crackBatch([&ciphertexts, &next](string& ciphertext){
+        if (next == ciphertexts.size()){
+            return false;
+        }
+        ciphertext = ciphertexts[next++];
+        return true;
+    }, [&results](BatchResult& result){
+        results[result.index] = std::move(result);
+    }, options, workers);
+    return results;
+}
 
-//******************** Decrypter functions ************************************
-// This class simply delegates all tasks to the DecrypterImpl class.
-// Done this way since this was a class project, and this allowed for simpler and universal testing.
 
-Decrypter::Decrypter()
+void DecrypterImpl::setCacheBudget(size_t bytes)
 {
-    m_impl = new DecrypterImpl;
+    m_cache.setBudget(bytes);
 }
 
-Decrypter::~Decrypter()
+
+CacheStats DecrypterImpl::cacheStats() const
 {
-    delete m_impl;
+    return m_cache.stats();
 }
 
-bool Decrypter::load(string filename)
+
+void DecrypterImpl::setCollectStats(bool collect)
 {
-    return m_impl->load(filename);
+    // Searches already running keep doing what they started with
+    m_collectStats = collect;
 }
 
-vector<string> Decrypter::crack(const string& ciphertext)
+
+CrackStats DecrypterImpl::stats() const
+{
+    lock_guard<mutex> guard(m_statsLock);
+    return m_stats;
+}
+
+
+void DecrypterImpl::resetStats()
+{
+    lock_guard<mutex> guard(m_statsLock);
+    m_stats = CrackStats();
+}
+
+
+shared_ptr<const vector<string>> DecrypterImpl::cachedSolutions(const string& ciphertext, const CrackOptions& options, string& key) const
+{
+    // Looks the message up in the cache.  key is set to its cache key, or left empty if the cache isn't to be used
+    key.clear();
+    if ( ! options.useCache || ! m_cache.enabled()){
+        return nullptr;
+    }
+    key = ResultCache::canonicalKey(ciphertext);
+    return m_cache.find(key);
+}
+
+
+CrackStatus DecrypterImpl::deliverCached(const vector<string>& solutions, const SolutionCallback& onSolution)
+{
+    for (int i = 0; i < (int)solutions.size(); i++){
+        if ( ! onSolution(solutions[i])){
+            return CrackStatus::Stopped;
+        }
+    }
+    return CrackStatus::Complete;
+}
+
+
+int DecrypterImpl::threadCount(const CrackOptions& options)
+{
+    if (options.threads <= 0){
+        return max(1, (int)thread::hardware_concurrency());
+    }
+    return options.threads;
+}
+
+
+CrackStatus DecrypterImpl::search(const string& ciphertext, SolutionSink& sink, const CrackOptions& options, int nThreads) const
+{
+    // Statistics are turned on or off for a whole search
+    bool collect = collectingStats();
+    CrackStats stats;
+
+    // Break up the message into the words, as views into the message
+    vector<string_view> cipherWords;
+    {
+        PhaseTimer timer(collect ? &stats.tokenizeSeconds : nullptr);
+        m_tokenizer->tokenize(ciphertext, cipherWords);
+    }
+
+    // If there are only separators (or empty string), just return the message
+    if (cipherWords.size() == 0){
+        sink.add(ciphertext);
+        return sink.status();
+    }
+
+    // Index which words contain which letters.  If some word can never be translated into the list (it has a
+    // character that isn't a letter or apostrophe, or no letters and isn't in the list), there are no solutions
+    CrackProblem problem;
+    if ( ! prepareProblem(ciphertext, cipherWords, problem)){
+        return CrackStatus::Complete;
+    }
+
+    if (problem.nUnmapped == 0){
+        // Nothing to translate, and every word is already in the list
+        sink.add(ciphertext);
+        return sink.status();
+    }
+
+    SearchLimits limits(options);
+    if (nThreads == 1){
+        // Call recursive function to find all possible solutions, starting from the root of the search
+        CrackSearch search(problem, sink, limits, nullptr, 0, collect);
+        search.run(SearchTask());
+        addStats(stats, search.stats());
+    } else {
+        searchParallel(problem, sink, limits, nThreads, collect, stats);
+    }
+
+    if (collect){
+        stats.searches = 1;
+        addStats(stats);
+    }
+    return sink.status();
+}
+
+
+void DecrypterImpl::searchParallel(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, int nThreads,
+                                   bool collectStats, CrackStats& stats) const
+{
+    // Every thread starts looking for work, and the first one finds the root of the search
+    TaskPool pool(nThreads);
+    pool.push(0, SearchTask());
+
+    vector<unique_ptr<CrackSearch>> searches;
+    for (int t = 0; t < nThreads; t++){
+        searches.push_back(unique_ptr<CrackSearch>(new CrackSearch(problem, sink, limits, &pool, t, collectStats)));
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++){
+        threads.push_back(thread([&pool, &searches, t](){
+            SearchTask task;
+            while (pool.next(t, task)){
+                searches[t]->run(task);
+                pool.finished();
+            }
+        }));
+    }
+    for (int t = 0; t < nThreads; t++){
+        threads[t].join();
+        addStats(stats, searches[t]->stats());
+    }
+}
+
+
+bool DecrypterImpl::collectingStats() const
+{
+#ifdef DECRYPTER_STATS
+    return m_collectStats.load(memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+
+void DecrypterImpl::addStats(const CrackStats& stats) const
+{
+    lock_guard<mutex> guard(m_statsLock);
+    addStats(m_stats, stats);
+}
+
+
+void DecrypterImpl::addStats(CrackStats& total, const CrackStats& stats)
+{
+    total.searches += stats.searches;
+    total.nodes += stats.nodes;
+    total.findCandidatesCalls += stats.findCandidatesCalls;
+    total.candidates += stats.candidates;
+    total.countCandidatesCalls += stats.countCandidatesCalls;
+    total.pushConflicts += stats.pushConflicts;
+    total.rejections += stats.rejections;
+    total.pruned += stats.pruned;
+    total.nogoodHits += stats.nogoodHits;
+    total.maxDepth = max(total.maxDepth, stats.maxDepth);
+    total.solutions += stats.solutions;
+    total.loadSeconds += stats.loadSeconds;
+    total.tokenizeSeconds += stats.tokenizeSeconds;
+    total.candidateSeconds += stats.candidateSeconds;
+    total.verifySeconds += stats.verifySeconds;
+}
+
+
+bool DecrypterImpl::prepareProblem(const string& ciphertext, const vector<string_view>& cipherWords, CrackProblem& problem) const
+{
+    problem.wl = m_wl.get();
+    problem.message = ciphertext;
+
+    bool inMessage[26] = {false};
+    problem.nUnmapped = 0;
+
+    int nWords = (int)cipherWords.size();
+    for (int i = 0; i < nWords; i++){
+        // Words are compared in upper case, the mapping is case-insensitive
+        string word(cipherWords[i]);
+        for (int j = 0; j < (int)word.size(); j++){
+            word[j] = toupper(word[j]);
+            if ( ! isupper(word[j]) && word[j] != '\''){
+                // No word in the list has any other character
+                return false;
+            }
+        }
+
+        vector<string>::iterator seen = find(problem.distinctWords.begin(), problem.distinctWords.end(), word);
+        if (seen != problem.distinctWords.end()){
+            // Just count another occurrence of a word that's already there
+            problem.wordCounts[seen - problem.distinctWords.begin()]++;
+            continue;
+        }
+
+        int w = (int)problem.distinctWords.size();
+        problem.distinctWords.push_back(word);
+        problem.wordCounts.push_back(1);
+
+        // Record every distinct letter of the word
+        bool inWord[26] = {false};
+        int nLetters = 0;
+        for (int j = 0; j < (int)word.size(); j++){
+            if (word[j] == '\''){
+                continue;
+            }
+            int c = word[j] - 'A';
+            if ( ! inWord[c]){
+                inWord[c] = true;
+                nLetters++;
+                problem.letterWords[c].push_back(w);
+            }
+            if ( ! inMessage[c]){
+                inMessage[c] = true;
+                problem.nUnmapped++;
+                problem.letters.push_back(c);
+            }
+        }
+        problem.unknownCount.push_back(nLetters);
+
+        if (nLetters == 0 && ! m_wl->contains(word)){
+            // A word with no letters is already fully translated
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+//******************** CrackSearch functions ************************************
+
+CrackSearch::CrackSearch(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, TaskPool* pool, int thread,
+                         bool collectStats)
+: m_problem(problem), m_sink(sink), m_limits(limits), m_pool(pool), m_thread(thread), m_unknownCount(problem.unknownCount),
+  m_nUnmapped(problem.nUnmapped), m_candidateCounts(problem.distinctWords.size(), 0), m_nSolutions(0), m_nSplits(0),
+  m_nFound(0), m_nodesToCheck(-1), m_unreported(0), m_collect(collectStats), m_depth(0)
+{
+    for (int c = 0; c < 26; c++){
+        m_domains[c] = ALL_LETTERS;
+    }
+    for (int w = 0; w < (int)problem.distinctWords.size(); w++){
+        unsigned int letters = 0;
+        const string& word = problem.distinctWords[w];
+        for (int j = 0; j < (int)word.size(); j++){
+            if (word[j] != '\''){
+                letters |= 1u << (word[j] - 'A');
+            }
+        }
+        m_wordLetters.push_back(letters);
+    }
+
+    if (limits.any()){
+        // Look at the limits before expanding the first node
+        m_nodesToCheck = 0;
+    }
+}
+
+void CrackSearch::run(const SearchTask& task)
+{
+    if (m_sink.stopped()){
+        // Nothing more is wanted, just let the task go
+        return;
+    }
+
+    // Replay the choices leading to the task's subtree.  Each choice narrows the domains as far as they go, and at
+    // the root they still need narrowing by the candidates of every word
+    unsigned int rootDomains[26];
+    memcpy(rootDomains, m_domains, sizeof(m_domains));
+    int nSteps = (int)task.path.size();
+    vector<Choice> choices(nSteps);
+    int applied = 0;
+    while (applied < nSteps && choose(task.path[applied].first, task.path[applied].second, choices[applied])){
+        applied++;
+    }
+
+    if (applied == nSteps && (nSteps > 0 || propagate())){
+        m_path = task.path;
+        m_depth = nSteps;
+        STATS(m_stats.maxDepth = max(m_stats.maxDepth, m_depth));
+        if (m_nUnmapped == 0){
+            // The last choice completed the message
+            solutionFound();
+        } else {
+            // Every word that isn't fully translated yet is still left to choose
+            vector<int> remaining;
+            for (int w = 0; w < (int)m_unknownCount.size(); w++){
+                if (m_unknownCount[w] > 0){
+                    remaining.push_back(w);
+                }
+            }
+            decryptWords(remaining);
+        }
+        m_path.clear();
+    }
+
+    // Undo the replayed choices so the next task starts from an empty mapping
+    while (applied > 0){
+        applied--;
+        unchoose(choices[applied]);
+    }
+    memcpy(m_domains, rootDomains, sizeof(m_domains));
+
+    // Report what a counting search found
+    if (m_nFound > 0){
+        m_sink.addCount(m_nFound);
+        m_nFound = 0;
+    }
+}
+
+
+const CrackStats& CrackSearch::stats() const
+{
+    return m_stats;
+}
+
+
+void CrackSearch::decryptWords(vector<int> remaining)
+{
+    // Every call is one node of the search
+    if (m_nodesToCheck >= 0 && ! withinLimits()){
+        return;
+    }
+    STATS(m_stats.nodes++);
+
+    // Words that other choices have already fully translated (and checked) need no choosing
+    remaining.erase(remove_if(remaining.begin(), remaining.end(), [this](int w){ return m_unknownCount[w] == 0; }),
+                    remaining.end());
+
+    // The same state can be reached by different choices, so skip it if it has already led nowhere
+    unsigned long long key;
+    unsigned long long check;
+    stateKey(remaining, key, check);
+    if (isNogood(key, check)){
+        STATS(m_stats.nogoodHits++);
+        return;
+    }
+    long long solutionsBefore = m_nSolutions;
+    long long splitsBefore = m_nSplits;
+
+    // Step 2
+    // Choose the word with the fewest candidates and erase it from the words that haven't been chosen.
+    // If some word has no candidates left, no choice made here can lead to a solution
+    int index = fewestCandidatesIndex(remaining);
+    if (index < 0){
+        return;
+    }
+    int w = remaining[index];
+    const string& current = m_problem.distinctWords[w];
+    remaining.erase(remaining.begin() + index);
+
+    // Step 3 and 4
+    // Find all possible words that match the cipher pattern and what its letters can still be, which takes in both
+    // the current mapping and the letters other words have already taken
+    vector<string> candidates;
+    {
+        STATS_TIMER(m_stats.candidateSeconds);
+        candidates = m_problem.wl->findCandidates(current, m_domains);
+    }
+    STATS(m_stats.findCandidatesCalls++; m_stats.candidates += candidates.size());
+
+    // Step 5
+    // If there are no possible candidates, return to previous call
+    int nCandidates = (int)candidates.size();
+    if (nCandidates == 0){
+        return;
+    }
+
+    // Step 6
+    for (int i = 0; i < nCandidates; i++){
+        // For every candidate word, until no more solutions are wanted
+        if (m_sink.stopped()){
+            break;
+        }
+
+        if (m_pool != nullptr && i + 1 < nCandidates && (int)m_path.size() < MAX_SPLIT_DEPTH && m_pool->hungry()){
+            // Another thread is out of work, so hand it the candidates after this one as separate subtrees
+            for (int j = i + 1; j < nCandidates; j++){
+                SearchTask task;
+                task.path = m_path;
+                task.path.push_back(make_pair(w, candidates[j]));
+                m_pool->push(m_thread, task);
+                m_nSplits++;
+            }
+            nCandidates = i + 1;
+        }
+
+        // part a, b and c
+        // Try to add a new mapping based on the current candidate word, and check the words it fully translates
+        Choice choice;
+        if ( ! choose(w, candidates[i], choice)){
+            // case i
+            // Overlapping letter mapping, or a fully translated word is not in the list of words, move onto the next
+            // candidate
+            continue;
+        }
+
+        STATS(m_stats.maxDepth = max(m_stats.maxDepth, m_depth + 1));
+        if (m_nUnmapped == 0){
+            // case iii
+            // If all words were fully translated and in the word list, translate the whole message and pass it on
+            solutionFound();
+        } else {
+            // case ii
+            // Otherwise, some words are not fully translated but those that are are in the map,
+            // recursively call this function, building upon the current map
+            if (m_pool != nullptr){
+                m_path.push_back(make_pair(w, candidates[i]));
+            }
+            m_depth++;
+            decryptWords(remaining);
+            m_depth--;
+            if (m_pool != nullptr){
+                m_path.pop_back();
+            }
+        }
+
+        // Get rid of the current mapping
+        unchoose(choice);
+    }
+
+    // Remember a state that was searched to the end without a solution.  One cut short by a limit or by the
+    // callback, or whose subtrees partly went to other threads, may still have some
+    if (m_nSolutions == solutionsBefore && m_nSplits == splitsBefore && ! m_sink.stopped()){
+        addNogood(key, check);
+    }
+}
+
+
+void CrackSearch::solutionFound()
+{
+    // The mapping translates every word into the list.  A counting search only needs to know that
+    STATS(m_stats.solutions++);
+    m_nSolutions++;
+    if (m_sink.countOnly()){
+        m_nFound++;
+    } else {
+        m_sink.add(m_translator.getTranslation(m_problem.message));
+    }
+}
+
+
+bool CrackSearch::withinLimits()
+{
+    // Counts a node, and every so often reports the nodes and checks the limits.  Returns false once the search
+    // has to stop
+    m_unreported++;
+    if (m_nodesToCheck > 0){
+        m_nodesToCheck--;
+        return true;
+    }
+
+    m_nodesToCheck = m_limits.check(m_unreported, m_sink);
+    m_unreported = 0;
+    return m_nodesToCheck >= 0;
+}
+
+
+int CrackSearch::fewestCandidatesIndex(const vector<int>& remaining)
+{
+    // Find the word with the fewest candidates under the current domains, since it branches the least.  propagate
+    // has just counted them.  Ties go to the word that would fix the most new letters.  Returns -1 if any word has no
+    // candidates at all
+    int nWords = (int)remaining.size();
+    if (nWords == 1){
+        // Nothing to choose between
+        return 0;
+    }
+
+    int bestIndex = -1;
+    int bestCount = 0;
+    int bestUnknown = 0;
+    for (int i = 0; i < nWords; i++){
+        int w = remaining[i];
+        int nCandidates = m_candidateCounts[w];
+        if (nCandidates == 0){
+            return -1;
+        }
+
+        if (bestIndex < 0 || nCandidates < bestCount || (nCandidates == bestCount && m_unknownCount[w] > bestUnknown)){
+            bestIndex = i;
+            bestCount = nCandidates;
+            bestUnknown = m_unknownCount[w];
+        }
+    }
+
+    // Return the index of the word with the fewest candidates
+    return bestIndex;
+}
+
+
+bool CrackSearch::choose(int w, const string& candidate, Choice& choice)
+{
+    // Maps distinct word w to the candidate and checks every word that becomes fully translated.
+    // If that fails nothing is changed, otherwise unchoose undoes it
+    const string& word = m_problem.distinctWords[w];
+
+    // The letters of the word that have no mapping yet are the ones the candidate will add
+    string translation = m_translator.getTranslation(word);
+    bool isNew[26] = {false};
+    choice.nLetters = 0;
+    for (int j = 0; j < (int)word.size(); j++){
+        if (translation[j] == '?'){
+            int c = word[j] - 'A';
+            if ( ! isNew[c]){
+                isNew[c] = true;
+                choice.letters[choice.nLetters++] = (unsigned char)c;
+            }
+        }
+    }
+
+    if ( ! m_translator.pushMapping(word, candidate)){
+        STATS(m_stats.pushConflicts++);
+        return false;
+    }
+
+    // Only the words the new letters just finished translating can have become wrong, so only check those
+    bool possible;
+    {
+        STATS_TIMER(m_stats.verifySeconds);
+        possible = mapLetters(choice.letters, choice.nLetters);
+    }
+    if ( ! possible){
+        STATS(m_stats.rejections++);
+        unmapLetters(choice.letters, choice.nLetters);
+        m_translator.popMapping();
+        return false;
+    }
+
+    // Each new letter is now its candidate letter and nothing else, which narrows what the other words can be.
+    // Once every letter is mapped there is nothing left to narrow
+    choice.narrowed = m_nUnmapped > 0;
+    if ( ! choice.narrowed){
+        return true;
+    }
+    memcpy(choice.domains, m_domains, sizeof(m_domains));
+    for (int j = 0; j < (int)word.size(); j++){
+        if (word[j] != '\''){
+            m_domains[word[j] - 'A'] = 1u << (tolower(candidate[j]) - 'a');
+        }
+    }
+    if ( ! propagate()){
+        STATS(m_stats.pruned++);
+        unchoose(choice);
+        return false;
+    }
+
+    return true;
+}
+
+
+void CrackSearch::unchoose(const Choice& choice)
+{
+    if (choice.narrowed){
+        memcpy(m_domains, choice.domains, sizeof(m_domains));
+    }
+    unmapLetters(choice.letters, choice.nLetters);
+    m_translator.popMapping();
+}
+
+
+bool CrackSearch::mapLetters(const unsigned char* letters, int n)
+{
+    // Records that the given cipher letters now have a mapping, then checks every word that just became fully
+    // translated against the word list.  unmapLetters must be called with the same letters afterwards, even if
+    // this returns false
+    m_nUnmapped -= n;
+
+    bool possible = true;
+    for (int k = 0; k < n; k++){
+        const vector<int>& words = m_problem.letterWords[letters[k]];
+        for (int i = 0; i < (int)words.size(); i++){
+            int w = words[i];
+            m_unknownCount[w]--;
+            // Only the last of the letters to reach a word sees it finished, so each word is checked once
+            if (possible && m_unknownCount[w] == 0 &&
+                ! m_problem.wl->contains(m_translator.getTranslation(m_problem.distinctWords[w]))){
+                possible = false;
+            }
+        }
+    }
+
+    return possible;
+}
+
+
+bool CrackSearch::propagate()
+{
+    // Narrows the domains until they are consistent with every word: each letter of a word that isn't fully
+    // translated keeps only the plaintext letters some candidate of that word gives it, and a plaintext letter that's
+    // the only one left for some cipher letter is taken from every other.  Narrowing one domain can narrow others,
+    // so it goes round until nothing changes, and then m_candidateCounts is up to date.
+    // Returns false if some word runs out of candidates or some letter out of plaintext letters, in which case the
+    // domains are left half narrowed for the caller to restore
+    bool changed = true;
+    while (changed){
+        changed = false;
+        if ( ! removeTakenLetters(changed)){
+            return false;
+        }
+
+        for (int w = 0; w < (int)m_unknownCount.size(); w++){
+            if (m_unknownCount[w] == 0){
+                // Already checked against the list when its last letter was mapped
+                continue;
+            }
+
+            const string& word = m_problem.distinctWords[w];
+            unsigned int supports[26] = {0};
+            int nCandidates;
+            {
+                STATS_TIMER(m_stats.candidateSeconds);
+                // Counting the words that match the mapping so far is only a few bitmap ANDs.  When there are too
+                // many of them to check one by one, the word is unlikely to narrow anything, so that count will do
+                nCandidates = m_problem.wl->countCandidates(word, m_translator.getTranslation(word));
+                if (nCandidates <= MAX_SUPPORT_SCAN){
+                    nCandidates = m_problem.wl->countCandidates(word, m_domains, supports);
+                } else {
+                    fill(supports, supports + 26, ALL_LETTERS);
+                }
+            }
+            STATS(m_stats.countCandidatesCalls++);
+            m_candidateCounts[w] = nCandidates;
+            if (nCandidates == 0){
+                return false;
+            }
+
+            for (int j = 0; j < (int)word.size(); j++){
+                if (word[j] == '\''){
+                    continue;
+                }
+                int c = word[j] - 'A';
+                if ((m_domains[c] & supports[c]) != m_domains[c]){
+                    m_domains[c] &= supports[c];
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool CrackSearch::removeTakenLetters(bool& changed)
+{
+    // No two cipher letters can be the same plaintext letter.  Every letter whose domain is down to one plaintext
+    // letter takes it from the domains of all the others, which may leave some of them down to one in turn.
+    // Sets changed if any domain got smaller, returns false if two letters are left with the same single letter or
+    // a letter is left with none
+    const vector<int>& letters = m_problem.letters;
+    int nLetters = (int)letters.size();
+    unsigned int handled = 0;       // Cipher letters whose single plaintext letter has been taken from the others
+    bool found = true;
+    while (found){
+        found = false;
+        for (int i = 0; i < nLetters; i++){
+            int c = letters[i];
+            unsigned int domain = m_domains[c];
+            if ((handled >> c) & 1 || (domain & (domain - 1)) != 0){
+                continue;
+            }
+            handled |= 1u << c;
+            found = true;
+
+            for (int k = 0; k < nLetters; k++){
+                int other = letters[k];
+                if (other == c || (m_domains[other] & domain) == 0){
+                    continue;
+                }
+                m_domains[other] &= ~domain;
+                changed = true;
+                if (m_domains[other] == 0){
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+void CrackSearch::stateKey(const vector<int>& remaining, unsigned long long& key, unsigned long long& check) const
+{
+    // Whether a node has solutions only depends on which words are left to choose and what their letters can
+    // still be: every other word is already fully translated and checked, and the plaintext letters taken by the
+    // mapping have been removed from every domain.  So nodes reached by different choices that agree on that much
+    // have the same subtrees, whatever the rest of their mappings
+    unsigned int letters = 0;
+    key = 0;
+    check = 0;
+    for (int i = 0; i < (int)remaining.size(); i++){
+        int w = remaining[i];
+        letters |= m_wordLetters[w];
+        key ^= mix(w + 1);
+        check ^= mix(~(unsigned long long)w);
+    }
+    for (int c = 0; c < 26; c++){
+        if ((letters >> c) & 1){
+            unsigned long long state = ((unsigned long long)c << 32) | m_domains[c];
+            key ^= mix(state ^ 0x5BD1E9955BD1E995ULL);
+            check ^= mix(state + 0x3C6EF372FE94F82BULL);
+        }
+    }
+    if (key == 0){
+        // 0 marks an empty slot
+        key = 1;
+    }
+}
+
+
+bool CrackSearch::isNogood(unsigned long long key, unsigned long long check) const
+{
+    if (m_nogoods.empty()){
+        return false;
+    }
+    const Nogood& slot = m_nogoods[key & (m_nogoods.size() - 1)];
+    return slot.key == key && slot.check == check;
+}
+
+
+void CrackSearch::addNogood(unsigned long long key, unsigned long long check)
+{
+    // The table has one slot per hash, and a new state simply replaces whatever was there, so it never grows
+    if (m_nogoods.empty()){
+        m_nogoods.assign((size_t)1 << NOGOOD_TABLE_BITS, Nogood{0, 0});
+    }
+    Nogood& slot = m_nogoods[key & (m_nogoods.size() - 1)];
+    slot.key = key;
+    slot.check = check;
+}
+
+
+unsigned long long CrackSearch::mix(unsigned long long x)
+{
+    // splitmix64's finalizer, which spreads every bit of x over the whole result
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+void CrackSearch::unmapLetters(const unsigned char* letters, int n)
+{
+    m_nUnmapped += n;
+    for (int k = 0; k < n; k++){
+        const vector<int>& words = m_problem.letterWords[letters[k]];
+        for (int i = 0; i < (int)words.size(); i++){
+            m_unknownCount[words[i]]++;
+        }
+    }
+}
+
+
+
+//******************** BestFirstSearch functions ************************************
+
+BestFirstSearch::BestFirstSearch(const CrackProblem& problem, SolutionSink& sink, SearchLimits& limits, int beamWidth)
+: m_problem(problem), m_sink(sink), m_limits(limits), m_beamWidth(max(beamWidth, 0)), m_allLetters(0)
+{
+    int nWords = (int)problem.distinctWords.size();
+    m_letterMask.assign(nWords, 0);
+    m_bestLogProb.assign(nWords, 0);
+    for (int w = 0; w < nWords; w++){
+        const string& word = problem.distinctWords[w];
+        for (int j = 0; j < (int)word.size(); j++){
+            if (word[j] != '\''){
+                m_letterMask[w] |= 1u << (word[j] - 'A');
+            }
+        }
+        m_allLetters |= m_letterMask[w];
+
+        // Every word in the list with the same pattern is a candidate before anything is mapped
+        vector<string> candidates = problem.wl->findCandidates(word, string(word.size(), '?'));
+        double best = -HUGE_VAL;
+        for (int i = 0; i < (int)candidates.size(); i++){
+            double logProb;
+            if (problem.wl->logProbability(candidates[i], logProb)){
+                best = max(best, logProb);
+            }
+        }
+        m_bestLogProb[w] = best;
+    }
+}
+
+void BestFirstSearch::run(int k, vector<ScoredSolution>& solutions)
+{
+    // Start from the empty mapping.  Words without letters are already translated
+    State root;
+    memset(root.mapping, 0, sizeof(root.mapping));
+    root.mapped = 0;
+    root.score = 0;
+    root.bound = 0;
+    int nWords = (int)m_problem.distinctWords.size();
+    for (int w = 0; w < nWords; w++){
+        double logProb = m_bestLogProb[w];
+        if (m_letterMask[w] == 0){
+            m_problem.wl->logProbability(m_problem.distinctWords[w], logProb);
+            root.score += m_problem.wordCounts[w] * logProb;
+        }
+        root.bound += m_problem.wordCounts[w] * logProb;
+    }
+    push(root);
+
+    // Nodes until the limits are next checked (-1 if there are none), and nodes not yet reported to them
+    long long nodesToCheck = m_limits.any() ? 0 : -1;
+    long long unreported = 0;
+    while ( ! m_queue.empty() && (int)solutions.size() < k){
+        // Every state taken off the queue is one node of the search
+        if (nodesToCheck >= 0){
+            unreported++;
+            if (nodesToCheck > 0){
+                nodesToCheck--;
+            } else {
+                nodesToCheck = m_limits.check(unreported, m_sink);
+                unreported = 0;
+                if (nodesToCheck < 0){
+                    return;
+                }
+            }
+        }
+
+        pop_heap(m_queue.begin(), m_queue.end(), lowerBound);
+        State state = m_queue.back();
+        m_queue.pop_back();
+
+        if ((m_allLetters & ~state.mapped) == 0){
+            // Every word is translated, and nothing left in the queue can score better
+            Translator translator;
+            buildTranslator(state, translator);
+            ScoredSolution solution;
+            solution.solution = translator.getTranslation(m_problem.message);
+            solution.logProb = state.score;
+            solutions.push_back(solution);
+        } else {
+            expand(state);
+        }
+    }
+}
+
+bool BestFirstSearch::lowerBound(const State& a, const State& b)
+{
+    // Heap order, so that the state with the highest bound is on top
+    return a.bound < b.bound;
+}
+
+void BestFirstSearch::buildTranslator(const State& state, Translator& translator) const
+{
+    // Push the whole mapping of the state at once
+    string cipher;
+    string plain;
+    for (int c = 0; c < 26; c++){
+        if (state.mapping[c] != 0){
+            cipher += (char)('A' + c);
+            plain += (char)state.mapping[c];
+        }
+    }
+    translator.pushMapping(cipher, plain);
+}
+
+void BestFirstSearch::expand(const State& state)
+{
+    Translator translator;
+    buildTranslator(state, translator);
+
+    // Branch on the word with the fewest candidates, as the exhaustive search does.  If some word has none, nothing
+    // can complete this state
+    int nWords = (int)m_problem.distinctWords.size();
+    vector<int> incomplete;
+    int chosen = -1;
+    int fewest = 0;
+    for (int w = 0; w < nWords; w++){
+        if ((m_letterMask[w] & ~state.mapped) == 0){
+            continue;
+        }
+        incomplete.push_back(w);
+        const string& word = m_problem.distinctWords[w];
+        int nCandidates = m_problem.wl->countCandidates(word, translator.getTranslation(word));
+        if (nCandidates == 0){
+            return;
+        }
+        if (chosen < 0 || nCandidates < fewest){
+            chosen = w;
+            fewest = nCandidates;
+        }
+    }
+
+    const string& word = m_problem.distinctWords[chosen];
+    vector<string> candidates = m_problem.wl->findCandidates(word, translator.getTranslation(word));
+    for (int i = 0; i < (int)candidates.size(); i++){
+        if ( ! translator.pushMapping(word, candidates[i])){
+            continue;
+        }
+
+        // Score the words the candidate finishes, and bound the rest
+        State child = state;
+        child.mapped |= m_letterMask[chosen];
+        double rest = 0;
+        bool possible = true;
+        for (int j = 0; j < (int)incomplete.size() && possible; j++){
+            int w = incomplete[j];
+            if ((m_letterMask[w] & ~child.mapped) != 0){
+                rest += m_problem.wordCounts[w] * m_bestLogProb[w];
+                continue;
+            }
+            double logProb;
+            possible = m_problem.wl->logProbability(translator.getTranslation(m_problem.distinctWords[w]), logProb);
+            child.score += m_problem.wordCounts[w] * logProb;
+        }
+        translator.popMapping();
+
+        if (possible){
+            for (int j = 0; j < (int)word.size(); j++){
+                if (word[j] != '\''){
+                    child.mapping[word[j] - 'A'] = (unsigned char)toupper(candidates[i][j]);
+                }
+            }
+            child.bound = child.score + rest;
+            push(child);
+        }
+    }
+}
+
+void BestFirstSearch::push(const State& state)
+{
+    m_queue.push_back(state);
+    push_heap(m_queue.begin(), m_queue.end(), lowerBound);
+
+    // With a beam, once the queue holds twice as many states as it may, keep only the best of them
+    if (m_beamWidth > 0 && (int)m_queue.size() > 2 * m_beamWidth){
+        nth_element(m_queue.begin(), m_queue.begin() + m_beamWidth, m_queue.end(), [](const State& a, const State& b){
+            return a.bound > b.bound;
+        });
+        m_queue.resize(m_beamWidth);
+        make_heap(m_queue.begin(), m_queue.end(), lowerBound);
+    }
+}
+
+
+
+//******************** PhaseTimer functions ************************************
+
+PhaseTimer::PhaseTimer(double* total)
+: m_total(total)
+{
+    if (m_total != nullptr){
+        m_start = chrono::steady_clock::now();
+    }
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    if (m_total != nullptr){
+        *m_total += chrono::duration<double>(chrono::steady_clock::now() - m_start).count();
+    }
+}
+
+
+
+//******************** SolutionSink functions ************************************
+
+SolutionSink::SolutionSink(const SolutionCallback* onSolution, bool shared)
+: m_onSolution(onSolution), m_shared(shared), m_status((int)CrackStatus::Complete), m_count(0)
+{}
+
+bool SolutionSink::add(const string& solution)
+{
+    // Returns false once the search has stopped
+    if (m_onSolution == nullptr){
+        m_count++;
+    } else if (m_shared){
+        lock_guard<mutex> guard(m_lock);
+        if ( ! stopped() && ! (*m_onSolution)(solution)){
+            stop(CrackStatus::Stopped);
+        }
+    } else if ( ! stopped() && ! (*m_onSolution)(solution)){
+        stop(CrackStatus::Stopped);
+    }
+    return ! stopped();
+}
+
+void SolutionSink::stop(CrackStatus reason)
+{
+    // Only the first reason to stop is kept
+    int expected = (int)CrackStatus::Complete;
+    m_status.compare_exchange_strong(expected, (int)reason);
+}
+
+CrackStatus SolutionSink::status() const
+{
+    return (CrackStatus)m_status.load();
+}
+
+void SolutionSink::addCount(long long nFound)
+{
+    m_count += nFound;
+}
+
+bool SolutionSink::countOnly() const
+{
+    return m_onSolution == nullptr;
+}
+
+long long SolutionSink::count() const
+{
+    return m_count;
+}
+
+bool SolutionSink::stopped() const
+{
+    // Checked at every search node, and a late look only costs a little wasted work, so no ordering is needed
+    return m_status.load(memory_order_relaxed) != (int)CrackStatus::Complete;
+}
+
+
+
+//******************** SearchLimits functions ************************************
+
+SearchLimits::SearchLimits(const CrackOptions& options)
+: m_deadline(options.deadline), m_maxNodes(options.maxNodes), m_cancel(options.cancel), m_nodes(0)
+{}
+
+bool SearchLimits::any() const
+{
+    return m_maxNodes > 0 || m_cancel != nullptr || m_deadline != chrono::steady_clock::time_point::max();
+}
+
+long long SearchLimits::check(long long newNodes, SolutionSink& sink)
+{
+    // Adds newNodes to the nodes expanded so far, and stops the search if a limit has been reached.
+    // Returns how many more nodes a search may expand before checking again, or -1 to stop
+    if (sink.stopped()){
+        return -1;
+    }
+
+    long long nodes = (m_nodes += newNodes);
+    long long interval = LIMIT_CHECK_INTERVAL;
+    if (m_maxNodes > 0){
+        if (nodes > m_maxNodes){
+            sink.stop(CrackStatus::NodeLimit);
+            return -1;
+        }
+        // Check again right at the budget
+        interval = min(interval, m_maxNodes - nodes);
+    }
+    if (m_cancel != nullptr && m_cancel->load(memory_order_relaxed)){
+        sink.stop(CrackStatus::Cancelled);
+        return -1;
+    }
+    if (m_deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= m_deadline){
+        sink.stop(CrackStatus::TimedOut);
+        return -1;
+    }
+    return interval;
+}
+
+
+
+//******************** SortedSolutions functions ************************************
+
+SortedSolutions::SortedSolutions(size_t bufferBytes)
+: m_bufferBytes(bufferBytes), m_usedBytes(0), m_failed(false)
+{}
+
+SortedSolutions::~SortedSolutions()
+{
+    // Temporary files delete themselves when closed
+    for (int i = 0; i < (int)m_runs.size(); i++){
+        fclose(m_runs[i]);
+    }
+}
+
+bool SortedSolutions::add(const string& solution)
+{
+    // Buffers a solution, spilling the buffer to a run once it's full.  Returns false if a run can't be written,
+    // in which case the buffer is kept and nothing more should be added
+    m_buffer.push_back(solution);
+    m_usedBytes += sizeof(string) + solution.size();
+    if (m_usedBytes >= m_bufferBytes && ! spill()){
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool SortedSolutions::spill()
+{
+    // Writes the buffer out, sorted, as a new run of length-prefixed records.  A run that can't be written in full
+    // is thrown away, leaving its solutions in the buffer
+    FILE* f = tmpfile();
+    if (f == nullptr){
+        return false;
+    }
+
+    sort(m_buffer.begin(), m_buffer.end());
+    bool written = true;
+    for (int i = 0; written && i < (int)m_buffer.size(); i++){
+        unsigned int length = (unsigned int)m_buffer[i].size();
+        written = fwrite(&length, sizeof(length), 1, f) == 1 && fwrite(m_buffer[i].data(), 1, length, f) == length;
+    }
+    if ( ! written || fflush(f) != 0){
+        fclose(f);
+        return false;
+    }
+    rewind(f);
+    m_runs.push_back(f);
+
+    vector<string>().swap(m_buffer);
+    m_usedBytes = 0;
+    return true;
+}
+
+bool SortedSolutions::readRecord(FILE* f, string& s)
+{
+    unsigned int length;
+    if (fread(&length, sizeof(length), 1, f) != 1){
+        return false;
+    }
+    s.resize(length);
+    return length == 0 || fread(&s[0], 1, length, f) == length;
+}
+
+bool SortedSolutions::deliver(const SolutionCallback& onSolution)
+{
+    // Passes every solution to onSolution in order, until it returns false.
+    // Returns true if every solution was delivered.  After a failed write that's every solution that was kept
+    sort(m_buffer.begin(), m_buffer.end());
+    if (m_runs.empty()){
+        // Everything fit in memory
+        for (int i = 0; i < (int)m_buffer.size(); i++){
+            if ( ! onSolution(m_buffer[i])){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Merge the runs and whatever is left in the buffer.  Each source has its current solution in heads, and the
+    // queue holds the sources by their current solution, smallest first.  The buffer is the last source
+    int nRuns = (int)m_runs.size();
+    vector<string> heads(nRuns + 1);
+    size_t bufferNext = 0;
+    auto later = [&heads](int a, int b){ return heads[b] < heads[a]; };
+    priority_queue<int, vector<int>, decltype(later)> queue(later);
+
+    for (int r = 0; r < nRuns; r++){
+        if (readRecord(m_runs[r], heads[r])){
+            queue.push(r);
+        }
+    }
+    if (bufferNext < m_buffer.size()){
+        heads[nRuns].swap(m_buffer[bufferNext++]);
+        queue.push(nRuns);
+    }
+
+    while ( ! queue.empty()){
+        int r = queue.top();
+        queue.pop();
+        if ( ! onSolution(heads[r])){
+            return false;
+        }
+
+        // Refill from the same source
+        if (r < nRuns){
+            if (readRecord(m_runs[r], heads[r])){
+                queue.push(r);
+            }
+        } else if (bufferNext < m_buffer.size()){
+            heads[nRuns].swap(m_buffer[bufferNext++]);
+            queue.push(nRuns);
+        }
+    }
+    return true;
+}
+
+
+
+//******************** TaskPool functions ************************************
+
+TaskPool::TaskPool(int nThreads)
+: m_pending(0), m_idle(0)
+{
+    for (int t = 0; t < nThreads; t++){
+        m_deques.push_back(unique_ptr<TaskDeque>(new TaskDeque));
+    }
+}
+
+void TaskPool::push(int thread, SearchTask task)
+{
+    m_pending++;
+    lock_guard<mutex> guard(m_deques[thread]->lock);
+    m_deques[thread]->tasks.push_back(move(task));
+}
+
+bool TaskPool::next(int thread, SearchTask& task)
+{
+    // Gets the next task for the given thread, waiting for one if there is still work going on anywhere.
+    // Returns false once every task has finished
+    if (popBack(thread, task) || stealFront(thread, task)){
+        return true;
+    }
+
+    m_idle++;
+    int spins = 0;
+    while (m_pending > 0){
+        if (popBack(thread, task) || stealFront(thread, task)){
+            m_idle--;
+            return true;
+        }
+        // Back off gradually, so waiting threads don't take time away from the busy ones
+        if (++spins < 64){
+            this_thread::yield();
+        } else {
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+    m_idle--;
+    return false;
+}
+
+void TaskPool::finished()
+{
+    m_pending--;
+}
+
+bool TaskPool::hungry() const
+{
+    return m_idle > 0;
+}
+
+bool TaskPool::popBack(int thread, SearchTask& task)
+{
+    TaskDeque& d = *m_deques[thread];
+    lock_guard<mutex> guard(d.lock);
+    if (d.tasks.empty()){
+        return false;
+    }
+    task = move(d.tasks.back());
+    d.tasks.pop_back();
+    return true;
+}
+
+bool TaskPool::stealFront(int thread, SearchTask& task)
+{
+    // Try every other thread's deque, starting with the next one
+    int nThreads = (int)m_deques.size();
+    for (int k = 1; k < nThreads; k++){
+        TaskDeque& d = *m_deques[(thread + k) % nThreads];
+        lock_guard<mutex> guard(d.lock);
+        if ( ! d.tasks.empty()){
+            task = move(d.tasks.front());
+            d.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+//******************** Decrypter functions ************************************
+// This class simply delegates all tasks to the DecrypterImpl class.
+// Done this way since this was a class project, and this allowed for simpler and universal testing.
+
+Decrypter::Decrypter()
+{
+    m_impl = new DecrypterImpl;
+}
+
+Decrypter::Decrypter(std::shared_ptr<const WordList> wordList)
+{
+    m_impl = new DecrypterImpl(wordList);
+}
+
+Decrypter::~Decrypter()
+{
+    delete m_impl;
+}
+
+bool Decrypter::load(string filename)
+{
+    return m_impl->load(filename);
+}
+
+vector<string> Decrypter::crack(const string& ciphertext)
+{
+   return m_impl->crack(ciphertext, CrackOptions(), nullptr);
+}
+
+vector<string> Decrypter::crack(const string& ciphertext, const CrackOptions& options, CrackStatus* status)
+{
+   return m_impl->crack(ciphertext, options, status);
+}
+
+CrackStatus Decrypter::crack(const string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options)
+{
+   return m_impl->crack(ciphertext, onSolution, options);
+}
+
+long long Decrypter::crackCount(const string& ciphertext, const CrackOptions& options, CrackStatus* status)
+{
+   return m_impl->crackCount(ciphertext, options, status);
+}
+
+vector<string> Decrypter::crackFirst(const string& ciphertext, int n, const CrackOptions& options, CrackStatus* status)
+{
+   return m_impl->crackFirst(ciphertext, n, options, status);
+}
+
+vector<ScoredSolution> Decrypter::crackBest(const string& ciphertext, int k, const CrackOptions& options, CrackStatus* status)
+{
+   return m_impl->crackBest(ciphertext, k, options, status);
+}
+
+ScoredSolution Decrypter::crackQuadgram(const string& ciphertext, const CrackOptions& options, CrackStatus* status)
+{
+   return m_impl->crackQuadgram(ciphertext, options, status);
+}
+
+void Decrypter::crackBatch(const function<bool(string&)>& nextCiphertext, const function<void(BatchResult&)>& onResult,
+                           const CrackOptions& options, int workers)
+{
+   m_impl->crackBatch(nextCiphertext, onResult, options, workers);
+}
+
+vector<BatchResult> Decrypter::crackBatch(const vector<string>& ciphertexts, const CrackOptions& options, int workers)
+{
+   return m_impl->crackBatch(ciphertexts, options, workers);
+}
+
+void Decrypter::setCacheBudget(size_t bytes)
+{
+   m_impl->setCacheBudget(bytes);
+}
+
+CacheStats Decrypter::cacheStats() const
+{
+   return m_impl->cacheStats();
+}
+
+void Decrypter::setCollectStats(bool collect)
+{
+   m_impl->setCollectStats(collect);
+}
+
+CrackStats Decrypter::stats() const
+{
+   return m_impl->stats();
+}
+
+void Decrypter::resetStats()
 {
-   return m_impl->crack(ciphertext);
+   m_impl->resetStats();
 }
@@ -0,0 +1,111 @@
+#include "MappedFile.h"
+#include <string>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define MAPPEDFILE_USE_MMAP 1
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+: m_data(nullptr), m_size(0), m_mapped(false) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string& filename)
+{
+    // Discard any file that is already open
+    close();
+    
+#ifdef MAPPEDFILE_USE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        ::close(fd);
+        return false;
+    }
+    
+    if (st.st_size == 0){
+        // mmap can't map an empty file, but an empty file is still a valid (empty) file
+        ::close(fd);
+        return true;
+    }
+    
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (p == MAP_FAILED){
+        return false;
+    }
+    
+    m_data = static_cast<const char*>(p);
+    m_size = (size_t)st.st_size;
+    m_mapped = true;
+    return true;
+#else
+    ifstream in(filename, ios::binary | ios::ate);
+    if ( ! in){
+        return false;
+    }
+    
+    streamoff len = in.tellg();
+    in.seekg(0);
+    if (len <= 0){
+        return true;
+    }
+    
+    char* buffer = new char[(size_t)len];
+    if ( ! in.read(buffer, len)){
+        delete [] buffer;
+        return false;
+    }
+    
+    m_data = buffer;
+    m_size = (size_t)len;
+    m_mapped = false;
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+    if (m_data == nullptr){
+        return;
+    }
+    
+#ifdef MAPPEDFILE_USE_MMAP
+    if (m_mapped){
+        munmap(const_cast<char*>(m_data), m_size);
+    } else {
+        delete [] m_data;
+    }
+#else
+    delete [] m_data;
+#endif
+    
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+const char* MappedFile::data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
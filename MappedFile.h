@@ -0,0 +1,31 @@
+// MappedFile.h
+
+// Read-only view of a whole file.  On POSIX systems the file is memory-mapped so that several processes loading the
+// same file share one copy in the page cache; elsewhere it falls back to reading the file into memory.
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const std::string& filename);
+    void close();
+    const char* data() const;
+    std::size_t size() const;
+    
+    // MappedFile objects cannot be copied or assigned
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+private:
+    const char* m_data;
+    std::size_t m_size;
+    bool m_mapped;      // true if m_data came from mmap, false if it was allocated with new[]
+};
+
+#endif // MAPPEDFILE_H
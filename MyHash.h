@@ -212,48 +212,33 @@ void MyHash<KeyType, ValueType>::insertOrUpdate(const KeyType &key, const ValueT
     // Otherwise, inserts new Node with key/value pair at the end of the linked list in the bucket.
     // Will increase table size if adding an item will exceed the load factor
     
-    Node* p = m_table[b];
-    
-    // If there are no Nodes in the bucket
-    if (p == nullptr){
-        // If adding the item will exceed the load factor, increase the table size
-        if (exceedsLoad(m_nItems + 1)){
-            increaseTable();
-        }
-        
-        // Add a new Node with the key/value pair and set that bucket to point to this Node
-        Node* n = new Node(key, value);
-        m_table[b] = n;
-        // Increase number of items by 1
-        m_nItems++;
-        return;
-    }
-
-    while (p->next != nullptr){
-        // Go through until the last item in the list
+    for (Node* p = m_table[b]; p != nullptr; p = p->next){
         // If the key is already there, update the value
         if (p->key == key){
             p->value = value;
             return;
         }
-        p = p->next;
     }
     
-    // Check the last Node in the list to see if the key is already there, and if so, update the value
-    if (p->key == key){
-        p->value = value;
-        return;
-    }
-
-
-    // If adding the item will exceed the load factor, increase the table size
+    // If adding the item will exceed the load factor, increase the table size.
+    // Growing moves every Node, so the bucket has to be recalculated for the new number of buckets
     if (exceedsLoad(m_nItems + 1)){
         increaseTable();
+        unsigned int hash(const KeyType& k);
+        b = hash(key) % m_nBuckets;
     }
     
     // Then add the new key/value pair at the end of the list in the bucket
     Node* n = new Node(key, value);
-    p->next = n;
+    if (m_table[b] == nullptr){
+        m_table[b] = n;
+    } else {
+        Node* p = m_table[b];
+        while (p->next != nullptr){
+            p = p->next;
+        }
+        p->next = n;
+    }
     
     // Increase number of items by 1
     m_nItems++;
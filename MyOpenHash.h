@@ -0,0 +1,324 @@
+// MyOpenHash.h
+
+// Open-addressing counterpart to MyHash with the same associate/find/reset interface.
+// Items live directly in one array of slots, so a lookup reads a few adjacent slots instead of chasing individually
+// allocated Nodes.  Slots are split into groups of 16, and every slot has a control byte that is either EMPTY or the
+// low 7 bits of its key's hash.  A lookup compares its 7 hash bits against all 16 control bytes of a group at once
+// (with SSE2 where available, otherwise with 64-bit word tricks), so keys are only compared on a likely match and a
+// miss usually ends at the first group.  The number of groups is always a power of two.
+#ifndef MYOPENHASH_H
+#define MYOPENHASH_H
+
+#include <functional>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYOPENHASH_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+template<typename KeyType, typename ValueType, typename Hasher = std::hash<KeyType>>
+class MyOpenHash
+{
+public:
+    MyOpenHash(double maxLoadFactor = 0.75);
+    ~MyOpenHash();
+    void reset();
+    void associate(const KeyType& key, const ValueType& value);
+    int getNumItems() const;
+    double getLoadFactor() const;
+
+    // for a map that can't be modified, return a pointer to const ValueType
+    const ValueType* find(const KeyType& key) const;
+
+    // for a modifiable map, return a pointer to modifiable ValueType
+    ValueType* find(const KeyType& key)
+    {
+        return const_cast<ValueType*>(const_cast<const MyOpenHash*>(this)->find(key));
+    }
+
+    // C++11 syntax for preventing copying and assignment
+    MyOpenHash(const MyOpenHash&) = delete;
+    MyOpenHash& operator=(const MyOpenHash&) = delete;
+
+private:
+
+    static const int GROUP_SIZE = 16;
+    static const unsigned char EMPTY = 0x80;    // Full slots hold 7 hash bits, so their high bit is never set
+
+    struct Item
+    {
+        KeyType key;
+        ValueType value;
+    };
+
+    unsigned char* m_ctrl;      // One control byte per slot
+    Item* m_items;
+
+    double m_load;
+    int m_nGroups;
+    int m_nItems;
+
+
+    void allocate(int nGroups);
+    void clear();
+    static unsigned long long hashKey(const KeyType& key);
+    static unsigned int matchByte(const unsigned char* group, unsigned char b);
+    static int lowestBit(unsigned int mask);
+    int findIndex(const KeyType& key, unsigned long long h) const;
+    void increaseTable();
+    void insertNew(unsigned long long h, KeyType key, ValueType value);
+
+};
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+MyOpenHash<KeyType, ValueType, Hasher>::MyOpenHash(double maxLoadFactor)
+: m_ctrl(nullptr), m_items(nullptr), m_load(maxLoadFactor), m_nGroups(0), m_nItems(0)
+{
+    // Start with one group of empty slots.
+    // An open table has to keep some slots empty, so the load factor can't go as high as MyHash's
+    allocate(1);
+    if (maxLoadFactor <= 0.0){
+        m_load = 0.75;
+    } else if (maxLoadFactor > 0.875){
+        m_load = 0.875;
+    }
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+MyOpenHash<KeyType, ValueType, Hasher>::~MyOpenHash()
+{
+    clear();
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::reset()
+{
+    // Delete everything and start again with one group of empty slots
+    clear();
+    allocate(1);
+    m_nItems = 0;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::associate(const KeyType& key, const ValueType& value)
+{
+    unsigned long long h = hashKey(key);
+
+    // If the key is already in the table, just update the value
+    int index = findIndex(key, h);
+    if (index >= 0){
+        m_items[index].value = value;
+        return;
+    }
+
+    // If adding the item will exceed the load factor, double the table size first
+    if (static_cast<double>(m_nItems + 1) / (m_nGroups * GROUP_SIZE) > m_load){
+        increaseTable();
+    }
+
+    insertNew(h, key, value);
+    m_nItems++;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+int MyOpenHash<KeyType, ValueType, Hasher>::getNumItems() const
+{
+    return m_nItems;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+double MyOpenHash<KeyType, ValueType, Hasher>::getLoadFactor() const
+{
+    return static_cast<double>(m_nItems) / (m_nGroups * GROUP_SIZE);
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+const ValueType* MyOpenHash<KeyType, ValueType, Hasher>::find(const KeyType& key) const
+{
+    int index = findIndex(key, hashKey(key));
+
+    // If not found, return nullptr
+    if (index < 0){
+        return nullptr;
+    }
+
+    return &(m_items[index].value);
+}
+
+
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::allocate(int nGroups)
+{
+    m_nGroups = nGroups;
+    m_ctrl = new unsigned char[nGroups * GROUP_SIZE];
+    memset(m_ctrl, EMPTY, nGroups * GROUP_SIZE);
+    m_items = new Item[nGroups * GROUP_SIZE];
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::clear()
+{
+    delete [] m_ctrl;
+    delete [] m_items;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+unsigned long long MyOpenHash<KeyType, ValueType, Hasher>::hashKey(const KeyType& key)
+{
+    // std::hash is the identity for integers on most libraries, so mix the bits before they pick a group
+    unsigned long long h = static_cast<unsigned long long>(Hasher()(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+unsigned int MyOpenHash<KeyType, ValueType, Hasher>::matchByte(const unsigned char* group, unsigned char b)
+{
+    // Returns a mask with bit i set when control byte i of the group equals b
+#ifdef MYOPENHASH_SSE2
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)b)));
+#else
+    const unsigned long long lows = 0x0101010101010101ULL;
+    const unsigned long long highs = 0x8080808080808080ULL;
+    const unsigned int one = 1;
+    bool littleEndian = (*reinterpret_cast<const unsigned char*>(&one) == 1);
+
+    unsigned int mask = 0;
+    for (int half = 0; half < 2; half++){
+        unsigned long long word;
+        memcpy(&word, group + half * 8, 8);
+        // Bytes equal to b become zero, then every zero byte gets its high bit set (exactly, with no carries)
+        unsigned long long x = word ^ (lows * b);
+        unsigned long long zero = ~(((x & ~highs) + ~highs) | x) & highs;
+        // Gather the high bit of every byte into the low 8 bits, lowest addressed byte first
+        unsigned int bits = (unsigned int)(((zero >> 7) * 0x0102040810204080ULL) >> 56);
+        if ( ! littleEndian){
+            // memcpy gave the bytes in machine order, so on a big-endian machine they come out reversed
+            unsigned int reversed = 0;
+            for (int i = 0; i < 8; i++){
+                if (bits & (1u << i)){
+                    reversed |= 1u << (7 - i);
+                }
+            }
+            bits = reversed;
+        }
+        mask |= bits << (half * 8);
+    }
+    return mask;
+#endif
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+int MyOpenHash<KeyType, ValueType, Hasher>::lowestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+int MyOpenHash<KeyType, ValueType, Hasher>::findIndex(const KeyType& key, unsigned long long h) const
+{
+    // The low 7 bits of the hash are kept in the control byte, the rest pick the first group to look in
+    unsigned char tag = (unsigned char)(h & 0x7F);
+    unsigned int groupMask = m_nGroups - 1;
+    unsigned int g = (unsigned int)(h >> 7) & groupMask;
+
+    for (unsigned int step = 1; ; step++){
+        const unsigned char* group = m_ctrl + g * GROUP_SIZE;
+
+        // Compare keys only in the slots whose stored hash bits match
+        for (unsigned int m = matchByte(group, tag); m != 0; m &= m - 1){
+            int index = g * GROUP_SIZE + lowestBit(m);
+            if (m_items[index].key == key){
+                return index;
+            }
+        }
+
+        // Items are never removed, so a group with an empty slot means the key would have been placed by now
+        if (matchByte(group, EMPTY) != 0){
+            return -1;
+        }
+
+        // Move on by 1, 2, 3, ... groups, which visits every group since the number of groups is a power of two
+        g = (g + step) & groupMask;
+    }
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::increaseTable()
+{
+    // Hold the old table temporarily
+    unsigned char* oldCtrl = m_ctrl;
+    Item* oldItems = m_items;
+    int oldSlots = m_nGroups * GROUP_SIZE;
+
+    // Set the table to twice the number of groups with every slot empty
+    allocate(m_nGroups * 2);
+
+    // Move every item across
+    for (int i = 0; i < oldSlots; i++){
+        if (oldCtrl[i] != EMPTY){
+            // Hash before the key is moved out (argument evaluation order isn't specified)
+            unsigned long long h = hashKey(oldItems[i].key);
+            insertNew(h, std::move(oldItems[i].key), std::move(oldItems[i].value));
+        }
+    }
+
+    delete [] oldCtrl;
+    delete [] oldItems;
+}
+
+
+template<typename KeyType, typename ValueType, typename Hasher>
+void MyOpenHash<KeyType, ValueType, Hasher>::insertNew(unsigned long long h, KeyType key, ValueType value)
+{
+    // Inserts a key that is known not to be in the table, assuming there is room for it, into the first empty slot
+    // along the same sequence of groups findIndex will search
+    unsigned int groupMask = m_nGroups - 1;
+    unsigned int g = (unsigned int)(h >> 7) & groupMask;
+
+    for (unsigned int step = 1; ; step++){
+        unsigned int empty = matchByte(m_ctrl + g * GROUP_SIZE, EMPTY);
+        if (empty != 0){
+            int index = g * GROUP_SIZE + lowestBit(empty);
+            m_ctrl[index] = (unsigned char)(h & 0x7F);
+            m_items[index].key = std::move(key);
+            m_items[index].value = std::move(value);
+            return;
+        }
+
+        g = (g + step) & groupMask;
+    }
+}
+
+#endif // MYOPENHASH_H
@@ -0,0 +1,77 @@
+// PatternKey.h
+
+// The key WordList files its buckets under: the letter pattern of a word packed into three 64-bit words.  Kept in a
+// header of its own so the benchmarks time the same key code the word list uses.
+#ifndef PATTERNKEY_H
+#define PATTERNKEY_H
+
+#include <cstddef>
+#include <cctype>
+
+// A letter pattern is packed into a PatternKey with KEY_CODE_BITS bits per character: 0 past the end of the word,
+// 1 for the first distinct letter, 2 for the second, and so on up to 26, and APOSTROPHE_CODE for an apostrophe.
+// "hello" is 1 2 3 3 4 and "don't" is 1 2 3 27 4
+const int KEY_CODE_BITS = 5;
+const int KEY_CODES_PER_WORD = 64 / KEY_CODE_BITS;
+const unsigned long long APOSTROPHE_CODE = 27;
+
+// Longer words don't fit in a PatternKey and are left out of the list
+const int MAX_WORD_LENGTH = 3 * KEY_CODES_PER_WORD;
+
+struct PatternKey
+{
+    unsigned long long bits[3] = {0, 0, 0};
+
+    bool operator==(const PatternKey& other) const
+    {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+};
+
+struct PatternKeyHash
+{
+    std::size_t operator()(const PatternKey& key) const
+    {
+        // Most keys only use the first word, so fold the others in with different odd multipliers
+        return (std::size_t)(key.bits[0] ^ key.bits[1] * 0x9E3779B97F4A7C15ULL ^ key.bits[2] * 0xC2B2AE3D27D4EB4FULL);
+    }
+};
+
+// Inline, since every candidate lookup of a search starts with one
+inline bool getKey(const char* s, int len, PatternKey& key)
+{
+    // Fails for anything that can't be a word in the list: too long, or a character other than a letter or apostrophe
+    if (len > MAX_WORD_LENGTH){
+        return false;
+    }
+
+    key = PatternKey();
+
+    // seen[c] is 1 + the order in which letter c first appeared in the word, 0 if it hasn't appeared yet
+    unsigned char seen[26] = {0};
+    unsigned long long nSeen = 0;
+
+    for (int i = 0; i < len; i++){
+        unsigned long long code;
+        if (s[i] == '\''){
+            code = APOSTROPHE_CODE;
+        } else if (std::isalpha((unsigned char)s[i])){
+            // Compare letters as lower case, as the key should be case-insensitive
+            int c = std::tolower((unsigned char)s[i]) - 'a';
+            if (seen[c] == 0){
+                seen[c] = (unsigned char)++nSeen;
+            }
+            code = seen[c];
+        } else {
+            return false;
+        }
+
+        // Pack the code for this position into the key
+        key.bits[i / KEY_CODES_PER_WORD] |= code << (KEY_CODE_BITS * (i % KEY_CODES_PER_WORD));
+    }
+
+    // Returns a key that is of a certain letter pattern
+    return true;
+}
+
+#endif // PATTERNKEY_H
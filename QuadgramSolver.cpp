@@ -0,0 +1,232 @@
+#include "QuadgramSolver.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+const int QUADGRAM_SYMBOLS = 27;
+const unsigned char QUADGRAM_EDGE = 26;
+
+// A swap has to improve the score by more than this to be taken, so rounding can't make a climb go round in circles
+const double MIN_IMPROVEMENT = 1e-9;
+
+QuadgramSolver::QuadgramSolver(const float* quadgrams, const vector<string_view>& words)
+: m_quadgrams(quadgrams)
+{
+    // Every word is scored on its own with an edge at each end, the same way the table was counted.
+    // Anything but a letter is left out
+    bool inText[26] = {false};
+    vector<unsigned char> symbols;
+    for (int i = 0; i < (int)words.size(); i++){
+        symbols.clear();
+        symbols.push_back(QUADGRAM_EDGE);
+        for (int j = 0; j < (int)words[i].size(); j++){
+            unsigned char c = words[i][j];
+            if (isalpha(c)){
+                int letter = toupper(c) - 'A';
+                symbols.push_back((unsigned char)letter);
+                inText[letter] = true;
+            }
+        }
+        symbols.push_back(QUADGRAM_EDGE);
+
+        for (int j = 0; j + 3 < (int)symbols.size(); j++){
+            int index = (int)m_windows.size();
+            Window window;
+            memcpy(window.symbols, &symbols[j], 4);
+            m_windows.push_back(window);
+
+            // Note the window under each distinct letter in it
+            for (int k = 0; k < 4; k++){
+                unsigned char s = window.symbols[k];
+                if (s != QUADGRAM_EDGE && (m_letterWindows[s].empty() || m_letterWindows[s].back() != index)){
+                    m_letterWindows[s].push_back(index);
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < 26; c++){
+        if (inText[c]){
+            m_letters.push_back(c);
+        }
+    }
+}
+
+
+CrackStatus QuadgramSolver::solve(const CrackOptions& options, int nThreads, unsigned char key[26], double& score) const
+{
+    // Runs options.restarts climbs on nThreads threads and gives the best key found, key[c] being the plaintext
+    // letter (0-25) of cipher letter c.  The climbs stop early at the deadline or when cancelled
+    atomic<int> nextRestart(0);
+    atomic<int> status((int)CrackStatus::Complete);
+    nThreads = max(1, min(nThreads, options.restarts));
+
+    vector<Best> best(nThreads);
+    vector<thread> threads;
+    for (int t = 1; t < nThreads; t++){
+        threads.push_back(thread(&QuadgramSolver::climbRestarts, this, cref(options), ref(nextRestart), ref(status), ref(best[t])));
+    }
+    climbRestarts(options, nextRestart, status, best[0]);
+    for (int t = 0; t < (int)threads.size(); t++){
+        threads[t].join();
+    }
+
+    // The best of every thread's best, ties going to the earliest restart so the result is always the same
+    int winner = 0;
+    for (int t = 1; t < nThreads; t++){
+        if (best[t].restart >= 0 && (best[winner].restart < 0 || best[t].score > best[winner].score ||
+                                     (best[t].score == best[winner].score && best[t].restart < best[winner].restart))){
+            winner = t;
+        }
+    }
+
+    if (best[winner].restart < 0){
+        // Not even one climb started
+        for (int c = 0; c < 26; c++){
+            key[c] = (unsigned char)c;
+        }
+        score = 0;
+    } else {
+        memcpy(key, best[winner].key, 26);
+        score = best[winner].score;
+    }
+    return (CrackStatus)status.load();
+}
+
+
+void QuadgramSolver::climbRestarts(const CrackOptions& options, atomic<int>& nextRestart, atomic<int>& status, Best& best) const
+{
+    best.restart = -1;
+    best.score = 0;
+
+    for (;;){
+        int restart = nextRestart++;
+        if (restart >= options.restarts || status.load() != (int)CrackStatus::Complete){
+            return;
+        }
+
+        // Each restart's random key depends only on the seed and the restart
+        seed_seq seeds{options.seed, (unsigned int)restart};
+        mt19937 rng(seeds);
+        unsigned char key[27];
+        double score = climb(rng, key, options, status);
+
+        if (best.restart < 0 || score > best.score){
+            best.score = score;
+            best.restart = restart;
+            memcpy(best.key, key, 26);
+        }
+    }
+}
+
+
+double QuadgramSolver::climb(mt19937& rng, unsigned char key[27], const CrackOptions& options, atomic<int>& status) const
+{
+    // Start from a random key, then keep taking every swap that improves it until none does
+    for (int c = 0; c < 26; c++){
+        key[c] = (unsigned char)c;
+    }
+    shuffle(key, key + 26, rng);
+    key[QUADGRAM_EDGE] = QUADGRAM_EDGE;
+
+    bool inText[26] = {false};
+    for (int i = 0; i < (int)m_letters.size(); i++){
+        inText[m_letters[i]] = true;
+    }
+
+    bool improved = true;
+    while (improved){
+        // Check the limits once a pass
+        if (options.cancel != nullptr && options.cancel->load(memory_order_relaxed)){
+            int expected = (int)CrackStatus::Complete;
+            status.compare_exchange_strong(expected, (int)CrackStatus::Cancelled);
+        } else if (options.deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= options.deadline){
+            int expected = (int)CrackStatus::Complete;
+            status.compare_exchange_strong(expected, (int)CrackStatus::TimedOut);
+        }
+        if (status.load(memory_order_relaxed) != (int)CrackStatus::Complete){
+            break;
+        }
+
+        // Try swapping every letter of the message with every other letter.  Swapping with a letter that isn't in
+        // the message gives the letter a plaintext letter nothing maps to yet
+        improved = false;
+        for (int i = 0; i < (int)m_letters.size(); i++){
+            int a = m_letters[i];
+            for (int b = 0; b < 26; b++){
+                if (b == a || (inText[b] && b < a)){
+                    // Swapping two letters of the message is only worth trying once
+                    continue;
+                }
+                if (swapDelta(key, a, b) > MIN_IMPROVEMENT){
+                    swap(key[a], key[b]);
+                    improved = true;
+                }
+            }
+        }
+    }
+
+    // Add it up again rather than trust the sum of the changes
+    return score(key);
+}
+
+
+double QuadgramSolver::score(const unsigned char key[27]) const
+{
+    double total = 0;
+    for (int i = 0; i < (int)m_windows.size(); i++){
+        total += windowScore(m_windows[i], key);
+    }
+    return total;
+}
+
+
+double QuadgramSolver::windowScore(const Window& window, const unsigned char key[27]) const
+{
+    const unsigned char* s = window.symbols;
+    return m_quadgrams[((key[s[0]] * QUADGRAM_SYMBOLS + key[s[1]]) * QUADGRAM_SYMBOLS + key[s[2]]) * QUADGRAM_SYMBOLS + key[s[3]]];
+}
+
+
+double QuadgramSolver::swapDelta(unsigned char key[27], int a, int b) const
+{
+    // How much swapping the plaintext letters of cipher letters a and b would change the score.  Only the windows
+    // containing a or b change, and a window containing both must only be counted once
+    const vector<int>& windowsA = m_letterWindows[a];
+    const vector<int>& windowsB = m_letterWindows[b];
+
+    double before = 0;
+    for (int i = 0; i < (int)windowsA.size(); i++){
+        before += windowScore(m_windows[windowsA[i]], key);
+    }
+    for (int i = 0; i < (int)windowsB.size(); i++){
+        const unsigned char* s = m_windows[windowsB[i]].symbols;
+        if (s[0] != a && s[1] != a && s[2] != a && s[3] != a){
+            before += windowScore(m_windows[windowsB[i]], key);
+        }
+    }
+
+    swap(key[a], key[b]);
+    double after = 0;
+    for (int i = 0; i < (int)windowsA.size(); i++){
+        after += windowScore(m_windows[windowsA[i]], key);
+    }
+    for (int i = 0; i < (int)windowsB.size(); i++){
+        const unsigned char* s = m_windows[windowsB[i]].symbols;
+        if (s[0] != a && s[1] != a && s[2] != a && s[3] != a){
+            after += windowScore(m_windows[windowsB[i]], key);
+        }
+    }
+    swap(key[a], key[b]);
+
+    return after - before;
+}
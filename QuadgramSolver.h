@@ -0,0 +1,51 @@
+// QuadgramSolver.h
+
+// Statistical solver for ciphertexts too long, or with too many words missing from the list, for the exact search.
+// Instead of requiring every word to be in the list, it hill-climbs over whole keys, scoring a key by the quadgram
+// log probabilities (from WordList::quadgramTable) of the words it produces.  A step swaps what two cipher letters
+// map to, and only the quadgrams containing those letters are rescored.  Climbs start from random keys and run in
+// parallel; each restart has its own seed, so the result doesn't depend on the number of threads.
+#ifndef QUADGRAMSOLVER_H
+#define QUADGRAMSOLVER_H
+
+#include "provided.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <atomic>
+
+class QuadgramSolver
+{
+public:
+    QuadgramSolver(const float* quadgrams, const std::vector<std::string_view>& words);
+    CrackStatus solve(const CrackOptions& options, int nThreads, unsigned char key[26], double& score) const;
+
+private:
+    // The four symbols of one quadgram of the ciphertext, cipher letters 0-25 or 26 for the edge of a word
+    struct Window
+    {
+        unsigned char symbols[4];
+    };
+
+    // The best key a thread has found, and which restart found it
+    struct Best
+    {
+        double score;
+        int restart;
+        unsigned char key[26];
+    };
+
+    const float* m_quadgrams;
+    std::vector<Window> m_windows;
+    std::vector<int> m_letterWindows[26];   // Every window containing each cipher letter, once
+    std::vector<int> m_letters;             // The cipher letters in the message
+
+    void climbRestarts(const CrackOptions& options, std::atomic<int>& nextRestart, std::atomic<int>& status, Best& best) const;
+    double climb(std::mt19937& rng, unsigned char key[27], const CrackOptions& options, std::atomic<int>& status) const;
+    double score(const unsigned char key[27]) const;
+    double windowScore(const Window& window, const unsigned char key[27]) const;
+    double swapDelta(unsigned char key[27], int a, int b) const;
+};
+
+#endif // QUADGRAMSOLVER_H
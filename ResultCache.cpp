@@ -0,0 +1,117 @@
+#include "ResultCache.h"
+#include <string>
+#include <vector>
+#include <cctype>
+
+using namespace std;
+
+// Bookkeeping of one entry (list node, map node and shared vector), on top of the strings themselves
+const size_t ENTRY_OVERHEAD = 160;
+
+ResultCache::ResultCache(size_t budgetBytes)
+: m_budget(budgetBytes), m_used(0), m_hits(0), m_misses(0) {}
+
+string ResultCache::canonicalKey(const string& message)
+{
+    // Relabel the letters a, b, c, ... in the order they first appear, ignoring case but keeping it, and keep every
+    // other character as it is.  Messages with the same key are the same up to the key of the cipher
+    char label[26] = {0};
+    char nextLabel = 'a';
+
+    string key(message);
+    for (int i = 0; i < (int)key.size(); i++){
+        unsigned char c = key[i];
+        if ( ! isalpha(c)){
+            continue;
+        }
+        int letter = tolower(c) - 'a';
+        if (label[letter] == 0){
+            label[letter] = nextLabel++;
+        }
+        key[i] = isupper(c) ? toupper(label[letter]) : label[letter];
+    }
+    return key;
+}
+
+shared_ptr<const vector<string>> ResultCache::find(const string& key)
+{
+    // Returns the solutions stored under key, or nullptr if there are none
+    lock_guard<mutex> guard(m_lock);
+    auto it = m_index.find(key);
+    if (it == m_index.end()){
+        m_misses++;
+        return nullptr;
+    }
+
+    // It's now the most recently used
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->solutions;
+}
+
+void ResultCache::insert(const string& key, const vector<string>& solutions)
+{
+    // Work out the size first, so that solutions too big to ever fit aren't copied
+    size_t bytes = ENTRY_OVERHEAD + 2 * key.size();
+    for (int i = 0; i < (int)solutions.size(); i++){
+        bytes += sizeof(string) + solutions[i].size();
+    }
+
+    lock_guard<mutex> guard(m_lock);
+    if (bytes > m_budget || m_index.find(key) != m_index.end()){
+        return;
+    }
+
+    // Make room, then add as the most recently used
+    evictTo(m_budget - bytes);
+    Entry entry;
+    entry.key = key;
+    entry.solutions = make_shared<const vector<string>>(solutions);
+    entry.bytes = bytes;
+    m_entries.push_front(entry);
+    m_index[key] = m_entries.begin();
+    m_used += bytes;
+}
+
+void ResultCache::setBudget(size_t budgetBytes)
+{
+    lock_guard<mutex> guard(m_lock);
+    m_budget = budgetBytes;
+    evictTo(budgetBytes);
+}
+
+void ResultCache::clear()
+{
+    // Drop every result, but keep counting hits and misses
+    lock_guard<mutex> guard(m_lock);
+    evictTo(0);
+}
+
+bool ResultCache::enabled() const
+{
+    lock_guard<mutex> guard(m_lock);
+    return m_budget > 0;
+}
+
+CacheStats ResultCache::stats() const
+{
+    lock_guard<mutex> guard(m_lock);
+    CacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_entries.size();
+    stats.bytes = m_used;
+    return stats;
+}
+
+void ResultCache::evictTo(size_t budgetBytes)
+{
+    // Drop the least recently used results until the rest fit in budgetBytes.  A crack still using dropped
+    // solutions keeps them alive through its own shared_ptr
+    while (m_used > budgetBytes && ! m_entries.empty()){
+        Entry& oldest = m_entries.back();
+        m_used -= oldest.bytes;
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+    }
+}
@@ -0,0 +1,56 @@
+// ResultCache.h
+
+// Least recently used cache of crack results.  Two ciphertexts that differ only by which cipher letter stands for
+// which (the same plaintext under a different key) have exactly the same solutions, so results are keyed on the
+// message with its letters relabeled in order of first appearance, the whole-message version of a word's pattern.
+// The cache holds solutions up to a budget of bytes, evicting the least recently used results to make room.
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "provided.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+class ResultCache
+{
+public:
+    ResultCache(std::size_t budgetBytes);
+    static std::string canonicalKey(const std::string& message);
+    std::shared_ptr<const std::vector<std::string>> find(const std::string& key);
+    void insert(const std::string& key, const std::vector<std::string>& solutions);
+    void setBudget(std::size_t budgetBytes);
+    void clear();
+    bool enabled() const;
+    CacheStats stats() const;
+
+    // ResultCache objects cannot be copied or assigned
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const std::vector<std::string>> solutions;
+        std::size_t bytes;
+    };
+
+    // Most recently used first.  The map finds a key's entry in the list
+    std::list<Entry> m_entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+
+    mutable std::mutex m_lock;      // Any number of cracks can use the cache at once
+    std::size_t m_budget;
+    std::size_t m_used;
+    long long m_hits;
+    long long m_misses;
+
+    void evictTo(std::size_t budgetBytes);
+};
+
+#endif // RESULTCACHE_H
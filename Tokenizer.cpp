@@ -1,5 +1,6 @@
 #include "provided.h"
 #include <string>
+#include <string_view>
 #include <vector>
 using namespace std;
 
@@ -8,60 +9,79 @@ class TokenizerImpl
 public:
     TokenizerImpl(string separators);
     vector<string> tokenize(const std::string& s) const;
+    void tokenize(std::string_view s, vector<std::string_view>& tokens) const;
 private:
-    string m_separators;
-    int m_nSeparators;
+    // One bit for each of the 256 byte values, set if that byte is a separator
+    unsigned long long m_separatorBits[4];
     
     bool isSeparator(const char a) const;
 };
 
 TokenizerImpl::TokenizerImpl(string separators)
 {
-    m_separators = separators;
-    m_nSeparators = (int)separators.size();
+    // Build the table once, so checking a character is a single lookup instead of a scan of every separator
+    for (int i = 0; i < 4; i++){
+        m_separatorBits[i] = 0;
+    }
+    for (int i = 0; i < (int)separators.size(); i++){
+        unsigned char c = separators[i];
+        m_separatorBits[c >> 6] |= 1ULL << (c & 63);
+    }
 }
 
 vector<string> TokenizerImpl::tokenize(const std::string& s) const
 {
-    int strLength = (int)s.size();
+    // Find the tokens, then copy each one in a single go
+    vector<std::string_view> tokens;
+    tokenize(s, tokens);
+    
     vector<string> v;           // Vector to be returned
-    string curr = "";           // Current stretch of string since last separator
+    v.reserve(tokens.size());
+    for (int i = 0; i < (int)tokens.size(); i++){
+        v.push_back(string(tokens[i]));
+    }
+    
+    return v;
+}
+
+
+void TokenizerImpl::tokenize(std::string_view s, vector<std::string_view>& tokens) const
+{
+    // Replaces the contents of tokens with views into s of every stretch of characters between separators.
+    // Nothing is copied, so the views are only good for as long as s is
+    tokens.clear();
+    
+    int strLength = (int)s.size();
+    int start = -1;             // Start of the current stretch of string since last separator, -1 if there's none
     for (int i = 0; i < strLength; i++){
         // For every character in the string
         if (isSeparator(s[i])){
-            // If it is a separator
-            if (curr != ""){
-                // If the current stretch of string since the last separator is not empty, add it to the vector
-                v.push_back(curr);
-                curr = "";          // Set the current stretch of string to empty
-                continue;
+            // If it is a separator and the current stretch of string is not empty, add it to the vector
+            if (start >= 0){
+                tokens.push_back(s.substr(start, i - start));
+                start = -1;
             }
-            // Otherwise, the stretch of string is empty, just continue onto the next character
             continue;
         }
         
-        // If it isn't a separator, add it to the current stretch of string
-        curr += s[i];
+        // If it isn't a separator, it starts a new stretch of string if there isn't one already
+        if (start < 0){
+            start = i;
+        }
     }
     
     // In the case that the string does not end in a separator, add the last part to the vector
-    if (curr != ""){
-        v.push_back(curr);
+    if (start >= 0){
+        tokens.push_back(s.substr(start));
     }
-    
-    return v;
 }
 
 
 bool TokenizerImpl::isSeparator(const char a) const
 {
-    // For every separator checks if the character is equal to the separator
-    for (int i = 0; i < m_nSeparators; i++){
-        if (m_separators[i] == a){
-            return true;
-        }
-    }
-    return false;
+    // Look up the character's bit in the table
+    unsigned char c = a;
+    return (m_separatorBits[c >> 6] >> (c & 63)) & 1;
 }
 
 //******************** Tokenizer functions ************************************
@@ -82,3 +102,8 @@ vector<string> Tokenizer::tokenize(const std::string& s) const
 {
     return m_impl->tokenize(s);
 }
+
+void Tokenizer::tokenize(std::string_view s, std::vector<std::string_view>& tokens) const
+{
+    m_impl->tokenize(s, tokens);
+}
@@ -1,6 +1,8 @@
 #include "provided.h"
 #include <string>
-#include <list>
+#include <vector>
+#include <array>
+#include <cctype>
 using namespace std;
 
 
@@ -8,25 +10,32 @@ class TranslatorImpl
 {
 public:
     TranslatorImpl();
-    bool pushMapping(string ciphertext, string plaintext);
+    bool pushMapping(const string& ciphertext, const string& plaintext);
     bool popMapping();
     string getTranslation(const string& ciphertext) const;
     
 private:
-    string m_currMap;
+    // The mapping is kept in both directions, indexed 0-25 : A-Z, holding the upper case letter a letter maps to, or
+    // 0 if it has no mapping yet.  Keeping the reverse direction makes checking for two cipher letters mapping to
+    // the same plaintext letter a single lookup
+    array<unsigned char, 26> m_cipherToPlain;
+    array<unsigned char, 26> m_plainToCipher;
     
-    list<string> m_maps;
+    // Undo log: the cipher letters (0-25) each push added to the mapping, and where in m_added each push starts.
+    // Popping only has to clear the letters the last push added
+    vector<unsigned char> m_added;
+    vector<int> m_pushStarts;
     
+    void undoTo(int start);
 };
 
 TranslatorImpl::TranslatorImpl()
 {
-    for (int i = 0; i < 26; i++){
-        m_currMap += '?';
-    }
+    m_cipherToPlain.fill(0);
+    m_plainToCipher.fill(0);
 }
 
-bool TranslatorImpl::pushMapping(string ciphertext, string plaintext)
+bool TranslatorImpl::pushMapping(const string& ciphertext, const string& plaintext)
 {
     int letters = (int)ciphertext.size();
     if (letters != plaintext.size()){
@@ -34,7 +43,7 @@ bool TranslatorImpl::pushMapping(string ciphertext, string plaintext)
         return false;
     }
     
-    string newMap = m_currMap;       // To hold the new mapping
+    int start = (int)m_added.size();
     
     for (int i = 0; i < letters; i++){
         // For every letter to be mapped
@@ -44,67 +53,68 @@ bool TranslatorImpl::pushMapping(string ciphertext, string plaintext)
             continue;
         }
         
-        // The mapping is done as an indexing of a string 0-25 : A-Z
-        // Meaning that whatever is at position 0 is what A maps to, whatever is at spot 2 is what C maps to, etc
-        int index = toupper(ciphertext[i]) - 'A';
-        
         if ( ! isalpha(ciphertext[i]) || ! isalpha(plaintext[i])){
-            // If there is a non-letter/apostrophe in either string, return false
+            // If there is a non-letter/apostrophe in either string, undo what this push has added and return false
+            undoTo(start);
             return false;
         }
         
+        // Make all uppercase to be consistent, should be case-insensitive anyway
+        int cipher = toupper(ciphertext[i]) - 'A';
+        unsigned char plain = (unsigned char)toupper(plaintext[i]);
         
-        // Checking for overlapping letter mapping
-        for (int j = 0; j < 26; j++){
-            // For every letter in the current mapping
-            
-            if (m_currMap[j] == '?'){
-                // If the current mapping is a ?, continue onto the next character
-                continue;
-            }
-            
-            if ((m_currMap[index] != '?' && toupper(plaintext[i]) != m_currMap[index]) || (toupper(plaintext[i]) == m_currMap[j] && index != j)){
-                // Protects against multiple letters mapping to the same letter, and also one letter mapping to multiple
-                return false;
-            }
+        if (m_cipherToPlain[cipher] == plain){
+            // Already mapped this way, by an earlier push or earlier in this one
+            continue;
         }
         
-        // Make all uppercase to be consistent, should be case-insensitive anyway
-        ciphertext[i] = toupper(ciphertext[i]);
-        plaintext[i] = toupper(plaintext[i]);
-        
+        if (m_cipherToPlain[cipher] != 0 || m_plainToCipher[plain - 'A'] != 0){
+            // Protects against one letter mapping to multiple, and also multiple letters mapping to the same letter
+            undoTo(start);
+            return false;
+        }
         
-        newMap[index] = plaintext[i];
+        m_cipherToPlain[cipher] = plain;
+        m_plainToCipher[plain - 'A'] = (unsigned char)('A' + cipher);
+        m_added.push_back((unsigned char)cipher);
     }
     
-    // Add the current map to the front of the list
-    m_maps.push_front(m_currMap);
-    
-    // Change the current map to the new one, which has the additional mappings
-    m_currMap = newMap;
+    // Remember where this push starts so it can be popped
+    m_pushStarts.push_back(start);
     
     return true;
 }
 
 bool TranslatorImpl::popMapping()
 {
-    // You cannot pop more than you can push/you cannot pop when the list is empty
-    if (m_maps.size() == 0){
+    // You cannot pop more than you can push/you cannot pop when nothing has been pushed
+    if (m_pushStarts.empty()){
         return false;
     }
     
-    // Change the current map to the one at the front of the list
-    m_currMap = m_maps.front();
-    m_maps.erase(m_maps.begin());
+    // Clear just the letters the last push added
+    undoTo(m_pushStarts.back());
+    m_pushStarts.pop_back();
     
     return true;
 }
 
+void TranslatorImpl::undoTo(int start)
+{
+    // Removes every mapping added after position start of the undo log
+    while ((int)m_added.size() > start){
+        int cipher = m_added.back();
+        m_plainToCipher[m_cipherToPlain[cipher] - 'A'] = 0;
+        m_cipherToPlain[cipher] = 0;
+        m_added.pop_back();
+    }
+}
+
 string TranslatorImpl::getTranslation(const string& ciphertext) const
 {
-    string result;
-    
     int len = (int)ciphertext.size();
+    string result(len, '?');
+    
     for (int i = 0; i < len; i++){
         // For every character in the cipher text
         
@@ -112,27 +122,18 @@ string TranslatorImpl::getTranslation(const string& ciphertext) const
             // If it's a letter, check it against the current mapping
             
             // The index is where the mapping is located for a given letter.
-            // If the current letter (ciphertext[i]) is A (or a), index will be 0, which is where the mapping for
-            // A is located in the currMap
-            int index = toupper(ciphertext[i]) - 'A';
-            if (m_currMap[index] != '?'){
-                // If there is a mapping for the current ciphertext letter, meaning there isn't a ? in that index,
-                // change the result letter to the plaintext letter
-                result += m_currMap[index];
-                
-                // If the ciphertext letter was lower case, change the result letter to lower case (default in upper)
+            // If the current letter (ciphertext[i]) is A (or a), index will be 0
+            unsigned char plain = m_cipherToPlain[toupper(ciphertext[i]) - 'A'];
+            if (plain != 0){
+                // If there is a mapping for the current ciphertext letter, change the result letter to the plaintext
+                // letter.  If the ciphertext letter was lower case, make the result letter lower case too
                 // Case sensitive string will be returned
-                if (islower(ciphertext[i])){
-                    result[i] = tolower(result[i]);
-                }
-                
-            } else {
-                // Otherwise it is a ?, so just add a ? to the result
-                result += '?';
+                result[i] = islower(ciphertext[i]) ? tolower(plain) : plain;
             }
+            // Otherwise the letter has no mapping, and it stays a ?
         } else {
             // Otherwise it is some other character, add that character to the result
-            result += ciphertext[i];
+            result[i] = ciphertext[i];
         }
     }
     
@@ -155,7 +156,7 @@ Translator::~Translator()
     delete m_impl;
 }
 
-bool Translator::pushMapping(string ciphertext, string plaintext)
+bool Translator::pushMapping(const string& ciphertext, const string& plaintext)
 {
     return m_impl->pushMapping(ciphertext, plaintext);
 }
@@ -1,32 +1,169 @@
 #include "provided.h"
-#include "MyHash.h"
+#include "MyOpenHash.h"
+#include "PatternKey.h"
+#include "MappedFile.h"
 #include <string>
 #include <vector>
 #include <functional>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <cctype>
+#include <algorithm>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 using namespace std;
 
+// Binary index files start with this magic string followed by the format version.  The index is written in the byte
+// order of the machine that built it, so a version mismatch is also what a byte-swapped file looks like.
+const char INDEX_MAGIC[8] = {'S', 'C', 'D', 'W', 'L', 'I', 'D', 'X'};
+// Version 2 files have no word frequencies, and are still loaded as if every word were equally likely
+const unsigned int INDEX_VERSION = 3;
+const unsigned int INDEX_VERSION_NO_FREQUENCIES = 2;
+
+// Buckets with at least this many words get a bitmap for every position and letter, smaller ones are just scanned
+const int MIN_BITMAP_BUCKET = 64;
+
+// Bitmaps are ANDed this many 64-bit words at a time (one AVX2 register)
+const int BITMAP_BLOCK = 4;
+
+// Quadgrams are over the 26 letters and one more symbol for the edge of a word
+const int QUADGRAM_SYMBOLS = 27;
+const int QUADGRAM_EDGE = 26;
+
+// Log probability given to quadgrams that never appear in the list, as a fraction of one occurrence
+const double UNSEEN_QUADGRAM = 0.01;
+
+// A text file is only split between loader threads into chunks of at least this many bytes, smaller files aren't
+// worth starting threads for
+const size_t MIN_LOAD_CHUNK = 1 << 20;
+
 class WordListImpl
 {
 public:
     WordListImpl();
     ~WordListImpl();
     bool loadWordList(string filename);
-    bool contains(string word) const;
+    void setLoadThreads(int nThreads);
+    bool saveIndex(string filename) const;
+    bool contains(string_view word) const;
+    bool logProbability(string_view word, double& logProb) const;
+    const float* quadgramTable() const;
     vector<string> findCandidates(string cipherWord, string currTranslation) const;
+    int countCandidates(string cipherWord, string currTranslation) const;
+    vector<string> findCandidates(string_view cipherWord, const unsigned int domains[26]) const;
+    int countCandidates(string_view cipherWord, const unsigned int domains[26], unsigned int supports[26]) const;
     
 private:
     
-    MyHash<string, vector<string>>* mh;
+    // All words with the same letter pattern are stored back to back in the word array.  Since every word in a
+    // bucket has the same length, the i-th word of a bucket starts at offset + i * length and words need no terminator
+    struct Bucket
+    {
+        unsigned int length;
+        unsigned int count;
+        unsigned long long offset;
+    };
+    
+    // A stretch of whole lines of a text file, and what the first pass of loading found in it.  Its patterns are
+    // numbered in the order they first appear in the chunk, and chunks are merged in file order, so the buckets end
+    // up in the same order however the file was split
+    struct TextChunk
+    {
+        const char* data;
+        size_t size;
+        string staged;                  // Its viable words, lower case, back to back
+        vector<int> wordPatterns;       // Pattern number of every staged word
+        vector<double> wordCounts;      // Frequency of every staged word, 0 if its line had none
+        vector<PatternKey> keys;        // Key of every pattern number
+        vector<unsigned int> lengths;   // Word length of every pattern number
+        vector<unsigned int> counts;    // Number of words of every pattern number
+        vector<int> buckets;                    // Bucket of every pattern number, filled in by the merge
+        vector<unsigned long long> starts;      // Where the pattern's first word goes in the word array
+        vector<unsigned long long> firstWords;  // And the number of that word in the word array
+    };
+    
+    // Layout of a binary index file: the header, then one Bucket for every letter pattern, then the word array,
+    // then the number of words of each length, then the sorted word array, then (from version 3) zeros up to a
+    // multiple of 4 bytes and the log probability of every sorted word as a float
+    struct IndexHeader
+    {
+        char magic[8];
+        unsigned int version;
+        unsigned int nBuckets;
+        unsigned long long wordBytes;
+    };
+    
+    MyOpenHash<PatternKey, int, PatternKeyHash>* mh;    // Maps each letter pattern to its index in m_buckets
     
-    bool viableWord(string& s);
-    string getKey(string s) const;
+    vector<Bucket> m_buckets;       // Every bucket in the order it is laid out in the word array
+    vector<unsigned long long> m_bitmaps;   // Position/letter bitmaps of every bucket that has them
+    vector<long long> m_bitmapStart;        // Where each bucket's bitmaps start in m_bitmaps, -1 if it has none
+    const char* m_words;            // The word array, pointing into either m_ownedWords or m_index
+    string m_ownedWords;            // Holds the word array when the list was loaded from a text file
+    MappedFile m_index;             // Holds the word array when the list was loaded from a binary index
+    int m_loadThreads;              // Threads to load text files with, 0 for one per hardware thread
+    
+    // The same words again, sorted by length and then alphabetically, for contains to binary search.
+    // Words of length L start at m_sortedWords + m_lengthStart[L] and there are m_lengthCount[L] of them
+    const char* m_sortedWords;
+    string m_ownedSortedWords;
+    unsigned int m_lengthCount[MAX_WORD_LENGTH + 1];
+    unsigned long long m_lengthStart[MAX_WORD_LENGTH + 1];
+    unsigned long long m_lengthFirstWord[MAX_WORD_LENGTH + 1];  // Number of the first sorted word of each length
+    
+    // Log probability of every sorted word, from the frequencies in the word list (add-one smoothed, so words
+    // without a frequency are all equally unlikely, and a list without any makes every word equally likely)
+    const float* m_sortedLogProbs;
+    vector<float> m_ownedSortedLogProbs;
+    vector<float> m_bucketLogProbs;     // The same for the word array, only kept while loading a text file
+    
+    // Quadgram log probabilities, only built the first time they are asked for
+    mutable mutex m_quadgramLock;
+    mutable vector<float> m_quadgrams;
+    
+    void clear();
+    bool loadText(const char* data, size_t size);
+    static void scanChunk(TextChunk& chunk);
+    static bool parseFrequency(const char* s, const char* end, double& count);
+    void placeChunk(const TextChunk& chunk, double logTotal);
+    void sortBucketsByFrequency();
+    long long findSorted(string_view word) const;
+    bool loadIndex();
+    static bool lowerCaseWords(const char* s, unsigned long long n);
+    void buildSortedWords();
+    void findLengthStarts();
+    void buildBitmaps();
+    static int bitmapStride(int nWords);
+    static int popCount(unsigned long long m);
+    static int lowestBit(unsigned long long m);
+    static void andBitmaps(const unsigned long long* const* bitmaps, int n, int w, unsigned long long* out);
+    int matchCandidates(string cipherWord, string currTranslation, vector<string>* out) const;
+    int matchDomains(string_view cipherWord, const unsigned int domains[26], unsigned int supports[26],
+                     vector<string>* out) const;
+    static bool viableWord(const char* s, int len, char* lower);
 };
 
 WordListImpl::WordListImpl()
-: mh(new MyHash<string, vector<string>>) {}
+: mh(new MyOpenHash<PatternKey, int, PatternKeyHash>), m_words(nullptr), m_loadThreads(0), m_sortedWords(nullptr),
+  m_sortedLogProbs(nullptr)
+{
+    clear();
+}
 
 WordListImpl::~WordListImpl()
 {
@@ -36,97 +173,617 @@ WordListImpl::~WordListImpl()
 bool WordListImpl::loadWordList(string filename)
 {
     // Discard old list of words if one exists
-    if (mh != nullptr){
-        mh->reset();
+    clear();
+    
+    // Binary indexes are mapped straight into memory, anything else is read as a text file with one word per line.
+    // Either way the whole file is mapped
+    if ( ! m_index.open(filename)){
+        return false;
     }
     
-    ifstream words(filename);
+    if (m_index.size() >= sizeof(INDEX_MAGIC) && memcmp(m_index.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0){
+        if ( ! loadIndex()){
+            // A corrupt index shouldn't leave a half loaded list behind
+            clear();
+            return false;
+        }
+    } else {
+        // The words are copied out of a text file, so it isn't needed afterwards
+        bool loaded = loadText(m_index.data(), m_index.size());
+        m_index.close();
+        if ( ! loaded){
+            clear();
+            return false;
+        }
+        sortBucketsByFrequency();
+        buildSortedWords();
+    }
     
-    if ( ! words){
+    buildBitmaps();
+    return true;
+}
+
+void WordListImpl::setLoadThreads(int nThreads)
+{
+    m_loadThreads = nThreads;
+}
+
+bool WordListImpl::saveIndex(string filename) const
+{
+    ofstream out(filename, ios::binary | ios::trunc);
+    if ( ! out){
         return false;
     }
     
-    string currWord;
-    while (getline(words, currWord)){
-        if ( ! viableWord(currWord)){
-            // viableWord also changes the word to lower case, as all functions for seach are case-insensitive
+    unsigned long long wordBytes = 0;
+    if ( ! m_buckets.empty()){
+        const Bucket& last = m_buckets.back();
+        wordBytes = last.offset + (unsigned long long)last.count * last.length;
+    }
+    
+    IndexHeader header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.nBuckets = (unsigned int)m_buckets.size();
+    header.wordBytes = wordBytes;
+    
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if ( ! m_buckets.empty()){
+        out.write(reinterpret_cast<const char*>(m_buckets.data()), m_buckets.size() * sizeof(Bucket));
+    }
+    if (wordBytes > 0){
+        out.write(m_words, wordBytes);
+    }
+    out.write(reinterpret_cast<const char*>(m_lengthCount), sizeof(m_lengthCount));
+    if (wordBytes > 0){
+        out.write(m_sortedWords, wordBytes);
+    }
+    
+    // Pad so the log probabilities are aligned when the file is mapped
+    unsigned long long written = sizeof(header) + m_buckets.size() * sizeof(Bucket) + 2 * wordBytes + sizeof(m_lengthCount);
+    const char zeros[4] = {0, 0, 0, 0};
+    out.write(zeros, (4 - written % 4) % 4);
+    unsigned long long nWords = m_lengthFirstWord[MAX_WORD_LENGTH] + m_lengthCount[MAX_WORD_LENGTH];
+    if (nWords > 0){
+        out.write(reinterpret_cast<const char*>(m_sortedLogProbs), nWords * sizeof(float));
+    }
+    
+    return (bool)out;
+}
+
+void WordListImpl::clear()
+{
+    mh->reset();
+    m_buckets.clear();
+    m_bitmaps.clear();
+    m_bitmapStart.clear();
+    m_words = nullptr;
+    m_ownedWords.clear();
+    m_sortedWords = nullptr;
+    m_ownedSortedWords.clear();
+    m_sortedLogProbs = nullptr;
+    m_ownedSortedLogProbs.clear();
+    m_bucketLogProbs.clear();
+    {
+        lock_guard<mutex> guard(m_quadgramLock);
+        m_quadgrams.clear();
+    }
+    for (int i = 0; i <= MAX_WORD_LENGTH; i++){
+        m_lengthCount[i] = 0;
+        m_lengthStart[i] = 0;
+        m_lengthFirstWord[i] = 0;
+    }
+    m_index.close();
+}
+
+bool WordListImpl::loadText(const char* data, size_t size)
+{
+    // Loads a text file, one word per line.  The file is split into chunks of whole lines, which are scanned in
+    // parallel: every viable word is lower-cased, keyed, and counted under its letter pattern.  The chunks' patterns
+    // are then merged into buckets in file order, and finally every chunk copies its words into the word array in
+    // parallel.  Every step is linear, and the result is the same whatever the number of threads
+    int nThreads = m_loadThreads;
+    if (nThreads <= 0){
+        nThreads = max(1, (int)thread::hardware_concurrency());
+    }
+    nThreads = (int)min((size_t)nThreads, max((size_t)1, size / MIN_LOAD_CHUNK));
+    
+    // Split at the first newline after each even share of the file
+    vector<TextChunk> chunks(nThreads);
+    size_t begin = 0;
+    for (int t = 0; t < nThreads; t++){
+        size_t end = size;
+        if (t < nThreads - 1){
+            end = max(begin, size * (t + 1) / nThreads);
+            const char* newline = static_cast<const char*>(memchr(data + end, '\n', size - end));
+            end = (newline == nullptr) ? size : (size_t)(newline - data) + 1;
+        }
+        chunks[t].data = data + begin;
+        chunks[t].size = end - begin;
+        begin = end;
+    }
+    
+    // First pass, a thread for every chunk but the first, which this thread does
+    vector<thread> threads;
+    for (int t = 1; t < nThreads; t++){
+        threads.push_back(thread(scanChunk, ref(chunks[t])));
+    }
+    scanChunk(chunks[0]);
+    for (int t = 0; t < (int)threads.size(); t++){
+        threads[t].join();
+    }
+    
+    // Merge the chunks' patterns in file order.  A bucket is numbered when its pattern is first seen, so the word
+    // array is laid out the same way every time the same file is loaded
+    for (int t = 0; t < nThreads; t++){
+        TextChunk& chunk = chunks[t];
+        int nPatterns = (int)chunk.keys.size();
+        chunk.buckets.resize(nPatterns);
+        for (int p = 0; p < nPatterns; p++){
+            int* index = mh->find(chunk.keys[p]);
+            if (index == nullptr){
+                Bucket newBucket;
+                newBucket.length = chunk.lengths[p];
+                newBucket.count = 0;
+                newBucket.offset = 0;
+                chunk.buckets[p] = (int)m_buckets.size();
+                mh->associate(chunk.keys[p], chunk.buckets[p]);
+                m_buckets.push_back(newBucket);
+            } else {
+                chunk.buckets[p] = *index;
+            }
+        }
+    }
+    
+    // Now that every bucket's size is known, lay the buckets out back to back in the word array.
+    // Within a bucket, each chunk's words come after those of the chunks before it
+    for (int t = 0; t < nThreads; t++){
+        const TextChunk& chunk = chunks[t];
+        for (int p = 0; p < (int)chunk.keys.size(); p++){
+            m_buckets[chunk.buckets[p]].count += chunk.counts[p];
+        }
+    }
+    unsigned long long wordBytes = 0;
+    unsigned long long nWords = 0;
+    int nBuckets = (int)m_buckets.size();
+    vector<unsigned long long> bucketFirstWord(nBuckets);
+    for (int i = 0; i < nBuckets; i++){
+        m_buckets[i].offset = wordBytes;
+        bucketFirstWord[i] = nWords;
+        wordBytes += (unsigned long long)m_buckets[i].count * m_buckets[i].length;
+        nWords += m_buckets[i].count;
+    }
+    vector<unsigned int> filled(nBuckets, 0);
+    for (int t = 0; t < nThreads; t++){
+        TextChunk& chunk = chunks[t];
+        int nPatterns = (int)chunk.keys.size();
+        chunk.starts.resize(nPatterns);
+        chunk.firstWords.resize(nPatterns);
+        for (int p = 0; p < nPatterns; p++){
+            const Bucket& b = m_buckets[chunk.buckets[p]];
+            chunk.starts[p] = b.offset + (unsigned long long)filled[chunk.buckets[p]] * b.length;
+            chunk.firstWords[p] = bucketFirstWord[chunk.buckets[p]] + filled[chunk.buckets[p]];
+            filled[chunk.buckets[p]] += chunk.counts[p];
+        }
+    }
+    
+    // Every word's probability is its frequency over the total, both add-one smoothed
+    double total = (double)nWords;
+    for (int t = 0; t < nThreads; t++){
+        for (int i = 0; i < (int)chunks[t].wordCounts.size(); i++){
+            total += chunks[t].wordCounts[i];
+        }
+    }
+    double logTotal = log(max(total, 1.0));
+    
+    // Second pass, every chunk copies its words to their places
+    m_ownedWords.resize(wordBytes);
+    m_bucketLogProbs.resize(nWords);
+    threads.clear();
+    for (int t = 1; t < nThreads; t++){
+        threads.push_back(thread(&WordListImpl::placeChunk, this, cref(chunks[t]), logTotal));
+    }
+    placeChunk(chunks[0], logTotal);
+    for (int t = 0; t < (int)threads.size(); t++){
+        threads[t].join();
+    }
+    
+    m_words = m_ownedWords.data();
+    return true;
+}
+
+
+void WordListImpl::scanChunk(TextChunk& chunk)
+{
+    // Lower-cases every viable word of the chunk into its staging array, in order, and counts how many words each
+    // letter pattern has
+    MyOpenHash<PatternKey, int, PatternKeyHash> patterns;
+    chunk.staged.reserve(chunk.size);
+    
+    char word[MAX_WORD_LENGTH];
+    size_t pos = 0;
+    while (pos < chunk.size){
+        // Find the end of the current line
+        const char* line = chunk.data + pos;
+        const char* newline = static_cast<const char*>(memchr(line, '\n', chunk.size - pos));
+        size_t len = (newline == nullptr) ? chunk.size - pos : (size_t)(newline - line);
+        pos += len + 1;
+        
+        // The word can be followed by spaces or tabs and its frequency
+        double count = 0;
+        for (size_t i = 0; i < len; i++){
+            if (line[i] == ' ' || line[i] == '\t'){
+                if ( ! parseFrequency(line + i, line + len, count)){
+                    // Not a frequency, so the line isn't a single word
+                    count = -1;
+                }
+                len = i;
+                break;
+            }
+        }
+        
+        if (count < 0 || len == 0 || len > (size_t)MAX_WORD_LENGTH || ! viableWord(line, (int)len, word)){
+            // viableWord also gives the word in lower case, as all functions for seach are case-insensitive
             // If the word isn't viable, continue onto the next line
             continue;
         }
         
         // Get the key (letter pattern) for the current word
-        string key = getKey(currWord);
+        // (viableWord has already checked everything getKey could fail on)
+        PatternKey key;
+        getKey(word, (int)len, key);
         
-        // Get the vector in the specific bucket with the specific key
-        vector<string>* wordVector = mh->find(key);
-        
-        if (wordVector == nullptr){
-            // If the pointer is nullptr, meaning no words with that key have been added,
-            // then create a new vector and add the new word to it
-            vector<string> newWordVector;
-            newWordVector.push_back(currWord);
-            // Put that vector into the hash table using the key
-            mh->associate(key, newWordVector);
+        // Find the pattern's number, or give it the next one if no words with that key have been seen yet
+        int* index = patterns.find(key);
+        int p;
+        if (index == nullptr){
+            p = (int)chunk.keys.size();
+            patterns.associate(key, p);
+            chunk.keys.push_back(key);
+            chunk.lengths.push_back((unsigned int)len);
+            chunk.counts.push_back(0);
         } else {
-            // Else, there has been at least one word with the same key (letter pattern) added to the table.
-            // Create a new vector and set it to the vector of words with that key retrieved by the find function,
-            // then push back the new word onto the vector and update that key in the table
-            // (Can't just update the current vector because not all hash tables are modifiable)
-            vector<string> newWordVector = *wordVector;
-            newWordVector.push_back(currWord);
-            mh->associate(key, newWordVector);
+            p = *index;
         }
+        
+        chunk.counts[p]++;
+        chunk.wordPatterns.push_back(p);
+        chunk.wordCounts.push_back(count);
+        chunk.staged.append(word, len);
     }
+}
 
-    return true;
+
+bool WordListImpl::parseFrequency(const char* s, const char* end, double& count)
+{
+    // Reads a non-negative number between s and end, surrounded by any spaces, tabs or carriage returns
+    char number[32];
+    int n = 0;
+    for (; s < end; s++){
+        if (*s == ' ' || *s == '\t' || *s == '\r'){
+            if (n > 0){
+                break;
+            }
+            continue;
+        }
+        if (n == (int)sizeof(number) - 1 || ( ! isdigit((unsigned char)*s) && *s != '.' && *s != 'e' && *s != 'E' && *s != '+')){
+            return false;
+        }
+        number[n++] = *s;
+    }
+    for (; s < end; s++){
+        if (*s != ' ' && *s != '\t' && *s != '\r'){
+            return false;
+        }
+    }
+    number[n] = '\0';
+    
+    char* parsed;
+    count = strtod(number, &parsed);
+    return n > 0 && parsed == number + n && count >= 0;
 }
 
-bool WordListImpl::contains(string word) const
+
+void WordListImpl::placeChunk(const TextChunk& chunk, double logTotal)
+{
+    // Copies every staged word of the chunk straight into the next free place of its bucket, along with its log
+    // probability.  Chunks never share places, so they can all do this at once
+    vector<unsigned long long> next(chunk.starts);
+    vector<unsigned long long> nextWord(chunk.firstWords);
+    const char* curr = chunk.staged.data();
+    int nWords = (int)chunk.wordPatterns.size();
+    for (int i = 0; i < nWords; i++){
+        int p = chunk.wordPatterns[i];
+        unsigned int length = chunk.lengths[p];
+        memcpy(&m_ownedWords[next[p]], curr, length);
+        m_bucketLogProbs[nextWord[p]++] = (float)(log(chunk.wordCounts[i] + 1) - logTotal);
+        next[p] += length;
+        curr += length;
+    }
+}
+
+
+void WordListImpl::sortBucketsByFrequency()
 {
-    // Get the key for the given word
-    string key = getKey(word);
-    // Get the pointer to the vector for the given key
-    vector<string>* words = mh->find(key);
+    // Puts the most frequent words of every bucket first, keeping words of equal frequency in file order, so that
+    // candidates come out most likely first.  A list without frequencies is left exactly as it was
+    unsigned long long firstWord = 0;
+    vector<int> order;
+    string words;
+    vector<float> logProbs;
+    for (int i = 0; i < (int)m_buckets.size(); i++){
+        const Bucket& b = m_buckets[i];
+        float* probs = &m_bucketLogProbs[firstWord];
+        firstWord += b.count;
+        
+        bool sorted = true;
+        for (unsigned int w = 1; w < b.count && sorted; w++){
+            sorted = probs[w - 1] >= probs[w];
+        }
+        if (sorted){
+            continue;
+        }
+        
+        order.resize(b.count);
+        for (unsigned int w = 0; w < b.count; w++){
+            order[w] = (int)w;
+        }
+        stable_sort(order.begin(), order.end(), [probs](int x, int y){ return probs[x] > probs[y]; });
+        
+        char* bucketWords = &m_ownedWords[b.offset];
+        words.assign(bucketWords, (size_t)b.count * b.length);
+        logProbs.assign(probs, probs + b.count);
+        for (unsigned int w = 0; w < b.count; w++){
+            memcpy(bucketWords + (size_t)w * b.length, words.data() + (size_t)order[w] * b.length, b.length);
+            probs[w] = logProbs[order[w]];
+        }
+    }
+}
+
+bool WordListImpl::loadIndex()
+{
+    const char* data = m_index.data();
+    size_t size = m_index.size();
     
-    // If that pointer is nullptr, the item is not in the hash table
-    if (words == nullptr){
+    if (size < sizeof(IndexHeader)){
         return false;
     }
     
-    // Make the word all lower case, contains should be case-insensitive
-    int wordSize = (int)word.size();
-    for (int i = 0; i < wordSize; i++){
-        word[i] = tolower(word[i]);
+    // Copy the fixed size parts out of the mapping rather than casting pointers into it
+    IndexHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != INDEX_VERSION && header.version != INDEX_VERSION_NO_FREQUENCIES){
+        return false;
     }
     
-    // For every word in the vector at that bucket with that key
-    int vSize = (int)(*words).size();
-    for (int i = 0; i < vSize; i++){
-        
-        // Make all words that were found totally lower case so that the comparison is case-insensitive
-        for (int j = 0; j < wordSize; j++){
-            (*words)[i][j] = tolower((*words)[i][j]);
+    // The file must be at least the header, the buckets, the word array, the length counts and the sorted word array.
+    // Both counts come straight from the file, so each is checked against what's left before anything is added up,
+    // where a huge one could wrap around
+    size_t fixedBytes = sizeof(IndexHeader) + sizeof(m_lengthCount);
+    if (size < fixedBytes || header.nBuckets > (size - fixedBytes) / sizeof(Bucket)){
+        return false;
+    }
+    unsigned long long bucketBytes = (unsigned long long)header.nBuckets * sizeof(Bucket);
+    if (header.wordBytes > (size - fixedBytes - bucketBytes) / 2){
+        return false;
+    }
+    unsigned long long wordsEnd = fixedBytes + bucketBytes + 2 * header.wordBytes;
+    
+    m_words = data + sizeof(IndexHeader) + bucketBytes;
+    memcpy(m_lengthCount, m_words + header.wordBytes, sizeof(m_lengthCount));
+    m_sortedWords = m_words + header.wordBytes + sizeof(m_lengthCount);
+    
+    // Both word arrays hold the same words
+    findLengthStarts();
+    if (m_lengthStart[MAX_WORD_LENGTH] + (unsigned long long)m_lengthCount[MAX_WORD_LENGTH] * MAX_WORD_LENGTH != header.wordBytes){
+        return false;
+    }
+    
+    // Then come the log probabilities, which an old index doesn't have
+    unsigned long long nWords = m_lengthFirstWord[MAX_WORD_LENGTH] + m_lengthCount[MAX_WORD_LENGTH];
+    if (header.version == INDEX_VERSION_NO_FREQUENCIES){
+        if (wordsEnd != size){
+            return false;
+        }
+        m_ownedSortedLogProbs.assign(nWords, (float)-log(max((double)nWords, 1.0)));
+        m_sortedLogProbs = m_ownedSortedLogProbs.data();
+    } else {
+        unsigned long long probsStart = (wordsEnd + 3) / 4 * 4;
+        if (probsStart + nWords * sizeof(float) != size){
+            return false;
+        }
+        m_sortedLogProbs = reinterpret_cast<const float*>(data + probsStart);
+    }
+
+    // Everything else indexes tables by the letters of the words, so a file with anything but lower case letters and
+    // apostrophes in either word array is rejected rather than trusted
+    if ( ! lowerCaseWords(m_words, header.wordBytes) || ! lowerCaseWords(m_sortedWords, header.wordBytes)){
+        return false;
+    }
+
+    m_buckets.resize(header.nBuckets);
+    if (header.nBuckets > 0){
+        memcpy(m_buckets.data(), data + sizeof(IndexHeader), bucketBytes);
+    }
+    
+    for (int i = 0; i < (int)header.nBuckets; i++){
+        const Bucket& b = m_buckets[i];
+        // Every bucket must hold at least one word and lie entirely inside the word array
+        if (b.length == 0 || (int)b.length > MAX_WORD_LENGTH || b.count == 0 || b.offset > header.wordBytes ||
+            (unsigned long long)b.count * b.length > header.wordBytes - b.offset){
+            return false;
         }
         
-        // If the word given equals a word in the vector, return true because it is found
-        if ((*words)[i] == word){
-            return true;
+        // The key isn't stored in the file since it is the letter pattern of any word in the bucket, and every word
+        // in the bucket must have it
+        PatternKey key;
+        if ( ! getKey(m_words + b.offset, (int)b.length, key)){
+            return false;
         }
+        for (unsigned int w = 1; w < b.count; w++){
+            PatternKey wordKey;
+            if ( ! getKey(m_words + b.offset + (size_t)w * b.length, (int)b.length, wordKey) || ! (wordKey == key)){
+                return false;
+            }
+        }
+        mh->associate(key, i);
     }
     
-    // Otherwise, if not found in that bucket or in that vector, return false
-    return false;
+    return true;
+}
+
+bool WordListImpl::lowerCaseWords(const char* s, unsigned long long n)
+{
+    // True if every one of the n characters is a lower case letter or an apostrophe
+    for (unsigned long long i = 0; i < n; i++){
+        if ((s[i] < 'a' || s[i] > 'z') && s[i] != '\''){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WordListImpl::contains(string_view word) const
+{
+    return findSorted(word) >= 0;
+}
+
+bool WordListImpl::logProbability(string_view word, double& logProb) const
+{
+    // Gives the log probability of a word in the list, returns false if it isn't in the list
+    long long index = findSorted(word);
+    if (index < 0){
+        return false;
+    }
+    logProb = m_sortedLogProbs[index];
+    return true;
+}
+
+const float* WordListImpl::quadgramTable() const
+{
+    // Counts the quadgrams of every word with an edge symbol at each end, so "the" gives _the and the_, each
+    // weighted by the word's probability.  The table is built the first time it's needed and then kept
+    lock_guard<mutex> guard(m_quadgramLock);
+    if ( ! m_quadgrams.empty()){
+        return m_quadgrams.data();
+    }
+    
+    int tableSize = QUADGRAM_SYMBOLS * QUADGRAM_SYMBOLS * QUADGRAM_SYMBOLS * QUADGRAM_SYMBOLS;
+    vector<double> counts(tableSize, 0.0);
+    double total = 0;
+    
+    int symbols[MAX_WORD_LENGTH + 2];
+    for (int len = 1; len <= MAX_WORD_LENGTH; len++){
+        const char* curr = m_sortedWords + m_lengthStart[len];
+        for (unsigned int w = 0; w < m_lengthCount[len]; w++, curr += len){
+            double weight = exp((double)m_sortedLogProbs[m_lengthFirstWord[len] + w]);
+            
+            // Apostrophes don't take part.  loadIndex only accepts lower case letters and apostrophes, but a word
+            // with anything else is skipped rather than allowed to index outside the table
+            int n = 0;
+            bool valid = true;
+            symbols[n++] = QUADGRAM_EDGE;
+            for (int j = 0; j < len; j++){
+                if (curr[j] == '\''){
+                    continue;
+                }
+                if (curr[j] < 'a' || curr[j] > 'z'){
+                    valid = false;
+                    break;
+                }
+                symbols[n++] = curr[j] - 'a';
+            }
+            if ( ! valid){
+                continue;
+            }
+            symbols[n++] = QUADGRAM_EDGE;
+            
+            for (int j = 0; j + 3 < n; j++){
+                int q = ((symbols[j] * QUADGRAM_SYMBOLS + symbols[j + 1]) * QUADGRAM_SYMBOLS + symbols[j + 2]) * QUADGRAM_SYMBOLS + symbols[j + 3];
+                counts[q] += weight;
+                total += weight;
+            }
+        }
+    }
+    
+    // The smallest weight a word can have stands for one occurrence
+    double occurrence = total;
+    for (int len = 1; len <= MAX_WORD_LENGTH; len++){
+        for (unsigned int w = 0; w < m_lengthCount[len]; w++){
+            occurrence = min(occurrence, exp((double)m_sortedLogProbs[m_lengthFirstWord[len] + w]));
+        }
+    }
+    
+    m_quadgrams.resize(tableSize);
+    double logTotal = log(max(total, 1e-300));
+    double unseen = log(max(UNSEEN_QUADGRAM * occurrence, 1e-300)) - logTotal;
+    for (int q = 0; q < tableSize; q++){
+        m_quadgrams[q] = (float)(counts[q] > 0 ? log(counts[q]) - logTotal : unseen);
+    }
+    return m_quadgrams.data();
+}
+
+long long WordListImpl::findSorted(string_view word) const
+{
+    // Returns the number of the word in the sorted word array, or -1 if it isn't in the list
+    int len = (int)word.size();
+    if (len == 0 || len > MAX_WORD_LENGTH){
+        return -1;
+    }
+    
+    // Make a lower case copy of the word, the search should be case-insensitive
+    // (The stored words were already made lower case when they were loaded)
+    char lower[MAX_WORD_LENGTH];
+    for (int i = 0; i < len; i++){
+        lower[i] = tolower((unsigned char)word[i]);
+    }
+    
+    // Binary search the words with the same length, which all take up len characters
+    const char* words = m_sortedWords + m_lengthStart[len];
+    unsigned int low = 0;
+    unsigned int high = m_lengthCount[len];
+    while (low < high){
+        unsigned int mid = low + (high - low) / 2;
+        int cmp = memcmp(words + (size_t)mid * len, lower, len);
+        if (cmp == 0){
+            return (long long)(m_lengthFirstWord[len] + mid);
+        } else if (cmp < 0){
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    // Otherwise, the word isn't in the list
+    return -1;
 }
 
 vector<string> WordListImpl::findCandidates(string cipherWord, string currTranslation) const
 {
+    // Vector of final candidates to be returned
+    vector<string> finalCandidates;
+    matchCandidates(cipherWord, currTranslation, &finalCandidates);
+    return finalCandidates;
+}
+
+
+int WordListImpl::countCandidates(string cipherWord, string currTranslation) const
+{
+    // Same as findCandidates, without building any of the strings
+    return matchCandidates(cipherWord, currTranslation, nullptr);
+}
+
+
+int WordListImpl::matchCandidates(string cipherWord, string currTranslation, vector<string>* out) const
+{
+    // Counts the words in the list matching cipherWord and currTranslation, adding them to out unless it is nullptr
     // cipherWord must be all letters and apostrophes
     // currTranslation must be all letters, apostrophes, and ?s
     
     int len = (int)cipherWord.size();
     // Return empty vector if the two parameters aren't the same length
     if (len != currTranslation.size()){
-        return vector<string>();
+        return 0;
     }
     
     // Return false if either string contains a character that isn't a letter nor an apostrophe
@@ -139,141 +796,407 @@ vector<string> WordListImpl::findCandidates(string cipherWord, string currTransl
         
         // If either string doesn't abide by the requirements (stated at top of function), return empty vector
         if ((! isupper(cipherWord[i]) && cipherWord[i] != '\'') || ( ! islower(currTranslation[i]) && currTranslation[i] != '\'' && currTranslation[i] != '?')){
-            return vector<string>();
+            return 0;
+        }
+        
+        // A cipher letter must translate to a letter or a ?, and an apostrophe only to an apostrophe
+        if ((cipherWord[i] == '\'') != (currTranslation[i] == '\'')){
+            return 0;
         }
     }
     
-    // Resets any cipher letter pattern to an equal pattern that matches the keys used in the word list has table
-    cipherWord = getKey(cipherWord);
+    // Turns the cipher letter pattern into the same kind of key used in the word list hash table
+    PatternKey key;
+    if ( ! getKey(cipherWord.data(), len, key)){
+        // Too long to match any word in the list
+        return 0;
+    }
     
-    // Find the vector of words matching the letter pattern
-    vector<string>* initialCandidates = mh->find(cipherWord);
+    // Find the bucket of words matching the letter pattern
+    const int* bucketIndex = mh->find(key);
     
-    if (initialCandidates == nullptr){
-        // If the poiter is nullptr, no words with that pattern were found, return empty vector
-        return vector<string>();
+    if (bucketIndex == nullptr){
+        // If the poiter is nullptr, no words with that pattern were found
+        return 0;
     }
     
-    // Vector of final candidates to be returned
-    vector<string> finalCandidates;
+    const Bucket& initialCandidates = m_buckets[*bucketIndex];
+    const char* bucketWords = m_words + initialCandidates.offset;
     
-    int nCandidates = (int)(*initialCandidates).size();
-    for (int i = 0; i < nCandidates; i++){
-        // For every word in the vector of possible words
-        
-        bool possibleCandidate = true;
-        
-        string curr = (*initialCandidates)[i];
-        
-        for (int j = 0; j < len; j++){
-            // For every letter in the three words
-            if (isalpha(currTranslation[j])){
-                // If the current translation character is a letter (known letter)
-                
-                if ( ! isalpha(cipherWord[j])){
-                    // If the cipher word isn't a letter at this character, return empty vector
-                    return vector<string>();
-                }
-                
-                if (curr[j] != currTranslation[j]){
-                    // If the current character of the current word isn't the same letter, break the loop and
-                    // set possibleCandidate to false so that the word will not be added to the finalCandidates
-                    possibleCandidate = false;
-                    break;
-                }
-                
-            } else if (currTranslation[j] == '?'){
-                // If the current translation is a ? (unknown letter)
-                
-                if ( ! isalpha(cipherWord[j])){
-                    // If the cipher word isn't a letter at this character, return empty vector
-                    return vector<string>();
-                }
-                
-                if ( ! isalpha(curr[j])){
-                    // If the current character of the current word isn't a letter, break the loop and
-                    // set possibleCandidate to false so that the word will not be added to the finalCandidates
+    // Every word in the bucket has the same letter pattern as the cipher word, so its letters and apostrophes are
+    // already in the right places.  All that is left is to check the letters that are already known
+    // (no word longer than MAX_WORD_LENGTH is ever loaded, so the bucket lookup has already ruled those out)
+    int known[MAX_WORD_LENGTH];
+    int nKnown = 0;
+    for (int j = 0; j < len; j++){
+        if (islower(currTranslation[j])){
+            known[nKnown++] = j;
+        }
+    }
+    
+    int nFound = 0;
+    
+    if (nKnown == 0 && out == nullptr){
+        // With no known letters at all, every word in the bucket matches
+        return (int)initialCandidates.count;
+    }
+    
+    if (m_bitmapStart[*bucketIndex] < 0 || nKnown == 0){
+        // Small buckets have no bitmaps, just check every word in the bucket against the known letters
+        // (with no known letters at all, that is every word in the bucket)
+        int nCandidates = (int)initialCandidates.count;
+        for (int i = 0; i < nCandidates; i++){
+            const char* curr = bucketWords + (size_t)i * len;
+            
+            bool possibleCandidate = true;
+            for (int k = 0; k < nKnown; k++){
+                if (curr[known[k]] != currTranslation[known[k]]){
                     possibleCandidate = false;
                     break;
                 }
-                
-            } else if (currTranslation[j] == '\'') {
-                // If the current translation is an apostrophe
-                
-                if (cipherWord[j] != '\''){
-                    // If the cipher word isn't an apostrophe at this character, return empty vector
-                    return vector<string>();
+            }
+            
+            if (possibleCandidate){
+                nFound++;
+                if (out != nullptr){
+                    out->push_back(string(curr, len));
                 }
-                
-                if (curr[j] != '\''){
-                    // If the current character of the current word isn't also an apostrophe, break the loop and
-                    // set possibleCandidate to false so that the word will not be added to the finalCandidates
+            }
+        }
+        
+        return nFound;
+    }
+    
+    // Otherwise the words that have every known letter in the right place are the AND of one bitmap per known letter
+    int stride = bitmapStride(initialCandidates.count);
+    const unsigned long long* first = &m_bitmaps[m_bitmapStart[*bucketIndex]];
+    const unsigned long long* bitmaps[MAX_WORD_LENGTH];
+    for (int k = 0; k < nKnown; k++){
+        bitmaps[k] = first + (size_t)(known[k] * 26 + (currTranslation[known[k]] - 'a')) * stride;
+    }
+    
+    for (int w = 0; w < stride; w += BITMAP_BLOCK){
+        // Matching words in this block of the bucket
+        unsigned long long block[BITMAP_BLOCK];
+        andBitmaps(bitmaps, nKnown, w, block);
+        
+        for (int b = 0; b < BITMAP_BLOCK; b++){
+            if (out == nullptr){
+                nFound += popCount(block[b]);
+                continue;
+            }
+            for (unsigned long long m = block[b]; m != 0; m &= m - 1){
+                // For every word in the block that matched, add it to the candidates
+                int i = (w + b) * 64 + lowestBit(m);
+                out->push_back(string(bucketWords + (size_t)i * len, len));
+                nFound++;
+            }
+        }
+    }
+    
+    // Return how many candidates match the current translation and cipher word
+    return nFound;
+}
+
+
+vector<string> WordListImpl::findCandidates(string_view cipherWord, const unsigned int domains[26]) const
+{
+    vector<string> candidates;
+    matchDomains(cipherWord, domains, nullptr, &candidates);
+    return candidates;
+}
+
+
+int WordListImpl::countCandidates(string_view cipherWord, const unsigned int domains[26], unsigned int supports[26]) const
+{
+    return matchDomains(cipherWord, domains, supports, nullptr);
+}
+
+
+int WordListImpl::matchDomains(string_view cipherWord, const unsigned int domains[26], unsigned int supports[26],
+                               vector<string>* out) const
+{
+    // Like matchCandidates, but every cipher letter may be any of a set of plaintext letters rather than one or all
+    // of them: bit p of domains[c] is set if cipher letter c can still be plaintext letter 'a' + p.  Letters with
+    // exactly one possibility are matched through the bitmaps like known letters, the rest are checked word by word.
+    // If supports isn't nullptr, every letter the matching words give cipher letter c is ORed into supports[c]
+    const unsigned int ALL_LETTERS = (1u << 26) - 1;
+    
+    int len = (int)cipherWord.size();
+    PatternKey key;
+    if ( ! getKey(cipherWord.data(), len, key)){
+        return 0;
+    }
+    const int* bucketIndex = mh->find(key);
+    if (bucketIndex == nullptr){
+        return 0;
+    }
+    const Bucket& bucket = m_buckets[*bucketIndex];
+    const char* bucketWords = m_words + bucket.offset;
+    
+    // Only the first position of each distinct cipher letter needs checking, the pattern makes the rest agree
+    int known[MAX_WORD_LENGTH];             // Positions of letters with one possibility
+    char knownLetter[MAX_WORD_LENGTH];
+    int nKnown = 0;
+    int open[MAX_WORD_LENGTH];              // Positions of letters with several, but not every, possibility
+    unsigned int openDomain[MAX_WORD_LENGTH];
+    int nOpen = 0;
+    int distinct[MAX_WORD_LENGTH];          // Positions of every distinct letter
+    int distinctLetter[MAX_WORD_LENGTH];
+    int nDistinct = 0;
+    bool seen[26] = {false};
+    for (int j = 0; j < len; j++){
+        if (cipherWord[j] == '\''){
+            continue;
+        }
+        int c = toupper((unsigned char)cipherWord[j]) - 'A';
+        if (seen[c]){
+            continue;
+        }
+        seen[c] = true;
+        distinct[nDistinct] = j;
+        distinctLetter[nDistinct++] = c;
+        
+        unsigned int domain = domains[c] & ALL_LETTERS;
+        if (domain == 0){
+            // Nothing left for this letter to be
+            return 0;
+        }
+        if ((domain & (domain - 1)) == 0){
+            known[nKnown] = j;
+            knownLetter[nKnown++] = (char)('a' + lowestBit(domain));
+        } else if (domain != ALL_LETTERS){
+            open[nOpen] = j;
+            openDomain[nOpen++] = domain;
+        }
+    }
+    
+    if (nKnown == 0 && nOpen == 0 && supports == nullptr && out == nullptr){
+        // Any letter will do, so every word in the bucket matches
+        return (int)bucket.count;
+    }
+    bool useBitmaps = m_bitmapStart[*bucketIndex] >= 0 && nKnown > 0;
+    
+    int nFound = 0;
+    auto check = [&](const char* curr){
+        // Counts and records a word whose known letters already match, if its other letters are possible too
+        for (int k = 0; k < nOpen; k++){
+            if (((openDomain[k] >> (curr[open[k]] - 'a')) & 1) == 0){
+                return;
+            }
+        }
+        nFound++;
+        if (supports != nullptr){
+            for (int k = 0; k < nDistinct; k++){
+                supports[distinctLetter[k]] |= 1u << (curr[distinct[k]] - 'a');
+            }
+        }
+        if (out != nullptr){
+            out->push_back(string(curr, len));
+        }
+    };
+    
+    if ( ! useBitmaps){
+        int nCandidates = (int)bucket.count;
+        for (int i = 0; i < nCandidates; i++){
+            const char* curr = bucketWords + (size_t)i * len;
+            bool possibleCandidate = true;
+            for (int k = 0; k < nKnown; k++){
+                if (curr[known[k]] != knownLetter[k]){
                     possibleCandidate = false;
                     break;
                 }
-                
-            } else {
-                // If there is somehow some other character here, return an empty vector
-                return vector<string>();
+            }
+            if (possibleCandidate){
+                check(curr);
             }
         }
+        return nFound;
+    }
+    
+    int stride = bitmapStride(bucket.count);
+    const unsigned long long* first = &m_bitmaps[m_bitmapStart[*bucketIndex]];
+    const unsigned long long* bitmaps[MAX_WORD_LENGTH];
+    for (int k = 0; k < nKnown; k++){
+        bitmaps[k] = first + (size_t)(known[k] * 26 + (knownLetter[k] - 'a')) * stride;
+    }
+    
+    for (int w = 0; w < stride; w += BITMAP_BLOCK){
+        unsigned long long block[BITMAP_BLOCK];
+        andBitmaps(bitmaps, nKnown, w, block);
         
-        // For each possible word, if it made it through every letter without anything making it not a possible
-        // candidate, add it to the finalCandidates vector
-        if (possibleCandidate){
-            finalCandidates.push_back(curr);
+        for (int b = 0; b < BITMAP_BLOCK; b++){
+            if (nOpen == 0 && supports == nullptr && out == nullptr){
+                // Only counting, and the bitmaps were the whole check
+                nFound += popCount(block[b]);
+                continue;
+            }
+            for (unsigned long long m = block[b]; m != 0; m &= m - 1){
+                int i = (w + b) * 64 + lowestBit(m);
+                check(bucketWords + (size_t)i * len);
+            }
         }
-        
     }
     
-    // Return all candidates that match the current translation and cipher word
-    return finalCandidates;
+    return nFound;
 }
 
 
-bool WordListImpl::viableWord(string &s)
+int WordListImpl::bitmapStride(int nWords)
 {
-    for (int i = 0; i < s.size(); i++){
-        // Change every letter in the word to lower case, as all functions are case-insensitive and this makes
-        // comparisons easier
-        s[i] = tolower(s[i]);
-        if ( ! islower(s[i]) && s[i] != '\''){
-            // If a character isn't a letter (checking lower works) and also isn't an apostrophe, return false
-            // to signify it is not a valid word
-            return false;
+    // Bitmaps are padded to whole blocks so the vector code never reads past the end of one
+    int words64 = (nWords + 63) / 64;
+    return (words64 + BITMAP_BLOCK - 1) / BITMAP_BLOCK * BITMAP_BLOCK;
+}
+
+
+int WordListImpl::popCount(unsigned long long m)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt64(m);
+#else
+    return __builtin_popcountll(m);
+#endif
+}
+
+
+int WordListImpl::lowestBit(unsigned long long m)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, m);
+    return (int)index;
+#else
+    return __builtin_ctzll(m);
+#endif
+}
+
+
+void WordListImpl::andBitmaps(const unsigned long long* const* bitmaps, int n, int w, unsigned long long* out)
+{
+    // Sets out to the AND of one block (starting at 64-bit word w) of each of the n bitmaps, n > 0
+#if defined(__AVX2__)
+    __m256i acc = _mm256_set1_epi64x(-1);
+    for (int k = 0; k < n; k++){
+        acc = _mm256_and_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitmaps[k] + w)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), acc);
+#elif defined(__ARM_NEON)
+    uint64x2_t lo = vdupq_n_u64(~0ULL);
+    uint64x2_t hi = vdupq_n_u64(~0ULL);
+    for (int k = 0; k < n; k++){
+        lo = vandq_u64(lo, vld1q_u64(bitmaps[k] + w));
+        hi = vandq_u64(hi, vld1q_u64(bitmaps[k] + w + 2));
+    }
+    vst1q_u64(out, lo);
+    vst1q_u64(out + 2, hi);
+#else
+    for (int b = 0; b < BITMAP_BLOCK; b++){
+        unsigned long long m = ~0ULL;
+        for (int k = 0; k < n; k++){
+            m &= bitmaps[k][w + b];
+        }
+        out[b] = m;
+    }
+#endif
+}
+
+
+void WordListImpl::buildSortedWords()
+{
+    // Collect every word with its log probability, then sort them by length and alphabetically within a length
+    vector<pair<const char*, float>> byLength[MAX_WORD_LENGTH + 1];
+    int nBuckets = (int)m_buckets.size();
+    size_t word = 0;
+    for (int i = 0; i < nBuckets; i++){
+        const Bucket& b = m_buckets[i];
+        const char* curr = m_words + b.offset;
+        for (unsigned int w = 0; w < b.count; w++, curr += b.length){
+            byLength[b.length].push_back(make_pair(curr, m_bucketLogProbs[word++]));
         }
     }
     
-    return true;
+    for (int len = 1; len <= MAX_WORD_LENGTH; len++){
+        sort(byLength[len].begin(), byLength[len].end(), [len](const pair<const char*, float>& a, const pair<const char*, float>& b){
+            return memcmp(a.first, b.first, len) < 0;
+        });
+        
+        m_lengthCount[len] = (unsigned int)byLength[len].size();
+        for (int i = 0; i < (int)byLength[len].size(); i++){
+            m_ownedSortedWords.append(byLength[len][i].first, len);
+            m_ownedSortedLogProbs.push_back(byLength[len][i].second);
+        }
+    }
+    
+    m_sortedWords = m_ownedSortedWords.data();
+    m_sortedLogProbs = m_ownedSortedLogProbs.data();
+    vector<float>().swap(m_bucketLogProbs);
+    findLengthStarts();
+}
+
+
+void WordListImpl::findLengthStarts()
+{
+    // The words of each length come right after all the shorter ones
+    m_lengthStart[0] = 0;
+    m_lengthFirstWord[0] = 0;
+    for (int len = 1; len <= MAX_WORD_LENGTH; len++){
+        m_lengthStart[len] = m_lengthStart[len - 1] + (unsigned long long)m_lengthCount[len - 1] * (len - 1);
+        m_lengthFirstWord[len] = m_lengthFirstWord[len - 1] + m_lengthCount[len - 1];
+    }
 }
 
 
-string WordListImpl::getKey(string s) const
+void WordListImpl::buildBitmaps()
 {
-    int strLength = (int)s.size();
-    string key = "";
+    // For every bucket big enough to be worth it, and for every position and letter, set bit i of that position and
+    // letter's bitmap when the i-th word of the bucket has that letter there
+    m_bitmaps.clear();
+    m_bitmapStart.assign(m_buckets.size(), -1);
     
-    // For every character in the word
-    for (int i = 0; i < strLength; i++){
-        if (s[i] == '\''){
-            key += '\'';
+    int nBuckets = (int)m_buckets.size();
+    for (int i = 0; i < nBuckets; i++){
+        const Bucket& b = m_buckets[i];
+        if (b.count < MIN_BITMAP_BUCKET || b.length > MAX_WORD_LENGTH){
             continue;
         }
-        // Set that character to A-Z based on its location in the word
-        key += ('A' + i);
-        for (int j = 0; j < i; j++){
-            // Check all previous letters in the word
-            // If equal to a previous letter, change the letter in the key to the same as the one given to the earlier
-            // letter.  Compare both as lower case letters as it should be case-insensitive
-            if (tolower(s[i]) == tolower(s[j])){
-                key[i] = key[j];
-                break;
+        
+        int stride = bitmapStride(b.count);
+        long long start = (long long)m_bitmaps.size();
+        m_bitmapStart[i] = start;
+        m_bitmaps.resize(m_bitmaps.size() + (size_t)b.length * 26 * stride, 0);
+        
+        const char* curr = m_words + b.offset;
+        for (unsigned int w = 0; w < b.count; w++, curr += b.length){
+            for (unsigned int j = 0; j < b.length; j++){
+                if (curr[j] != '\''){
+                    m_bitmaps[start + (size_t)(j * 26 + (curr[j] - 'a')) * stride + w / 64] |= 1ULL << (w % 64);
+                }
             }
         }
     }
+}
+
+
+bool WordListImpl::viableWord(const char* s, int len, char* lower)
+{
+    // Writes the word to lower, which must have room for len characters
+    if (len > MAX_WORD_LENGTH){
+        return false;
+    }
+    
+    for (int i = 0; i < len; i++){
+        // Change every letter in the word to lower case, as all functions are case-insensitive and this makes
+        // comparisons easier
+        lower[i] = tolower((unsigned char)s[i]);
+        if ( ! islower((unsigned char)lower[i]) && lower[i] != '\''){
+            // If a character isn't a letter (checking lower works) and also isn't an apostrophe, return false
+            // to signify it is not a valid word
+            return false;
+        }
+    }
     
-    // Returns a key that is of a certain letter pattern
-    return key;
+    return true;
 }
 
 
@@ -313,12 +1236,47 @@ bool WordList::loadWordList(string filename)
     return m_impl->loadWordList(filename);
 }
 
-bool WordList::contains(string word) const
+void WordList::setLoadThreads(int nThreads)
+{
+    m_impl->setLoadThreads(nThreads);
+}
+
+bool WordList::saveIndex(string filename) const
+{
+    return m_impl->saveIndex(filename);
+}
+
+bool WordList::contains(string_view word) const
 {
     return m_impl->contains(word);
 }
 
+bool WordList::logProbability(string_view word, double& logProb) const
+{
+    return m_impl->logProbability(word, logProb);
+}
+
+const float* WordList::quadgramTable() const
+{
+    return m_impl->quadgramTable();
+}
+
 vector<string> WordList::findCandidates(string cipherWord, string currTranslation) const
 {
    return m_impl->findCandidates(cipherWord, currTranslation);
 }
+
+vector<string> WordList::findCandidates(string_view cipherWord, const unsigned int domains[26]) const
+{
+   return m_impl->findCandidates(cipherWord, domains);
+}
+
+int WordList::countCandidates(string_view cipherWord, const unsigned int domains[26], unsigned int supports[26]) const
+{
+   return m_impl->countCandidates(cipherWord, domains, supports);
+}
+
+int WordList::countCandidates(string cipherWord, string currTranslation) const
+{
+   return m_impl->countCandidates(cipherWord, currTranslation);
+}
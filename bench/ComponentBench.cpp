@@ -0,0 +1,506 @@
+// ComponentBench.cpp
+
+// Microbenchmarks of every component, so a change can be checked for regressions against the previous version.
+// Inputs all come from the word list and a fixed seed, so two runs on the same list time exactly the same work.
+// Each benchmark doubles its iterations until it has run for at least the minimum time, and the results are written
+// to standard output as JSON in the same layout as Google Benchmark's --benchmark_format=json, so the usual
+// comparison scripts work on them.  Progress goes to standard error.
+//
+// Usage: componentbench [wordlist.txt] [minimum seconds per benchmark] [name filter]
+
+#include "provided.h"
+#include "MyHash.h"
+#include "MyOpenHash.h"
+#include "PatternKey.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cctype>
+#include <thread>
+#include <filesystem>
+using namespace std;
+
+const unsigned int SEED = 20240531;
+const int SAMPLE_WORDS = 512;
+
+// Benchmarks add their results here so the compiler can't throw the work away
+volatile long long g_sink = 0;
+
+// One benchmark: runs its body the given number of times and returns how many items that processed
+struct Benchmark
+{
+    string name;
+    function<long long(long long)> body;
+};
+
+struct Result
+{
+    string name;
+    long long iterations;
+    double realNs;          // Per iteration
+    double cpuNs;           // Per iteration
+    double itemsPerSecond;
+};
+
+// Encrypt with a key drawn from rng, the same way main.cpp's encrypt does with a random device
+string encrypt(const string& plaintext, mt19937& rng)
+{
+    char plaintextAlphabet[26+1];
+    iota(plaintextAlphabet, plaintextAlphabet+26, 'a');
+    plaintextAlphabet[26] = '\0';
+
+    string ciphertextAlphabet(plaintextAlphabet);
+    shuffle(ciphertextAlphabet.begin(), ciphertextAlphabet.end(), rng);
+
+    Translator t;
+    t.pushMapping(plaintextAlphabet, ciphertextAlphabet);
+    return t.getTranslation(plaintext);
+}
+
+Result runBenchmark(const Benchmark& b, double minSeconds)
+{
+    // Double the iterations until a run takes long enough to time reliably
+    long long iterations = 1;
+    for (;;){
+        clock_t cpuStart = clock();
+        auto start = chrono::steady_clock::now();
+        long long items = b.body(iterations);
+        double real = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double cpu = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+
+        if (real >= minSeconds || iterations >= (1LL << 40)){
+            Result r;
+            r.name = b.name;
+            r.iterations = iterations;
+            r.realNs = real * 1e9 / iterations;
+            r.cpuNs = cpu * 1e9 / iterations;
+            r.itemsPerSecond = real > 0 ? items / real : 0;
+            return r;
+        }
+
+        // Aim straight for the minimum time once there's a usable measurement
+        long long next = iterations * 2;
+        if (real > minSeconds / 100){
+            next = max(next, (long long)(iterations * 1.4 * minSeconds / real));
+        }
+        iterations = min(next, iterations * 100);
+    }
+}
+
+string jsonString(const string& s)
+{
+    string out = "\"";
+    for (int i = 0; i < (int)s.size(); i++){
+        if (s[i] == '"' || s[i] == '\\'){
+            out += '\\';
+        }
+        out += s[i];
+    }
+    return out + "\"";
+}
+
+void writeJson(ostream& out, const string& executable, const string& filename, const vector<Result>& results)
+{
+    time_t now = time(nullptr);
+    char date[64];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": " << jsonString(date) << ",\n";
+    out << "    \"executable\": " << jsonString(executable) << ",\n";
+    out << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n";
+    out << "    \"word_list\": " << jsonString(filename) << ",\n";
+    out << "    \"seed\": " << SEED << ",\n";
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\"\n";
+#else
+    out << "    \"library_build_type\": \"debug\"\n";
+#endif
+    out << "  },\n";
+    out << "  \"benchmarks\": [";
+    for (int i = 0; i < (int)results.size(); i++){
+        const Result& r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\n";
+        out << "      \"name\": " << jsonString(r.name) << ",\n";
+        out << "      \"run_name\": " << jsonString(r.name) << ",\n";
+        out << "      \"run_type\": \"iteration\",\n";
+        out << "      \"iterations\": " << r.iterations << ",\n";
+        out << "      \"real_time\": " << r.realNs << ",\n";
+        out << "      \"cpu_time\": " << r.cpuNs << ",\n";
+        out << "      \"time_unit\": \"ns\",\n";
+        out << "      \"items_per_second\": " << r.itemsPerSecond << "\n";
+        out << "    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    double minSeconds = argc > 2 ? stod(argv[2]) : 0.5;
+    string filter = argc > 3 ? argv[3] : "";
+
+    // Read the words once for building inputs
+    ifstream in(filename);
+    if ( ! in){
+        cerr << "Unable to load word list file " << filename << endl;
+        return 1;
+    }
+    vector<string> words;
+    string line;
+    while (getline(in, line)){
+        // Only the word, if the line also has a frequency
+        line = line.substr(0, line.find_first_of(" \t\r"));
+        if ( ! line.empty()){
+            words.push_back(line);
+        }
+    }
+    in.close();
+    if (words.empty()){
+        cerr << "No words in " << filename << endl;
+        return 1;
+    }
+
+    WordList wl;
+    if ( ! wl.loadWordList(filename)){
+        cerr << "Unable to load word list file " << filename << endl;
+        return 1;
+    }
+
+    mt19937 rng(SEED);
+    vector<Benchmark> benchmarks;
+
+    //******************** WordList ****************************************
+
+    benchmarks.push_back({"WordList/loadWordList/text", [&](long long n){
+        for (long long i = 0; i < n; i++){
+            WordList loaded;
+            g_sink += loaded.loadWordList(filename);
+        }
+        return n * (long long)words.size();
+    }});
+
+    // The scratch index goes in the temporary directory, under a name no other run is using, rather than next to
+    // the word list, which may be read-only or shared
+    error_code ec;
+    filesystem::path tempDir = filesystem::temp_directory_path(ec);
+    string indexFile;
+    bool haveIndex = false;
+    if ( ! ec){
+        random_device device;
+        indexFile = (tempDir / ("componentbench-" + to_string(device()) + "-" +
+                                to_string(chrono::steady_clock::now().time_since_epoch().count()) + ".idx")).string();
+        haveIndex = wl.saveIndex(indexFile);
+    }
+    if (haveIndex){
+        benchmarks.push_back({"WordList/loadWordList/index", [&](long long n){
+            for (long long i = 0; i < n; i++){
+                WordList loaded;
+                g_sink += loaded.loadWordList(indexFile);
+            }
+            return n * (long long)words.size();
+        }});
+    }
+
+    // Sample words, split by how many words share their letter pattern, since that decides the cost of finding them
+    const int bucketLimits[] = {1, 10, 100, 1000, 1 << 30};
+    const char* bucketNames[] = {"1", "2-10", "11-100", "101-1000", "1001+"};
+    vector<string> bucketCipher[5];
+    vector<string> bucketUnknown[5];
+    vector<int> order(words.size());
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), rng);
+    for (int i = 0; i < (int)order.size(); i++){
+        const string& w = words[order[i]];
+        if (w.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ'") != string::npos){
+            continue;
+        }
+        string unknown;
+        for (int j = 0; j < (int)w.size(); j++){
+            unknown += w[j] == '\'' ? '\'' : '?';
+        }
+        string cipher = encrypt(w, rng);
+        int count = wl.countCandidates(cipher, unknown);
+        int b = 0;
+        while (count > bucketLimits[b]){
+            b++;
+        }
+        if ((int)bucketCipher[b].size() < SAMPLE_WORDS){
+            bucketCipher[b].push_back(cipher);
+            bucketUnknown[b].push_back(unknown);
+        }
+    }
+    for (int b = 0; b < 5; b++){
+        if (bucketCipher[b].empty()){
+            continue;
+        }
+        benchmarks.push_back({string("WordList/findCandidates/bucket:") + bucketNames[b], [&, b](long long n){
+            const vector<string>& cipher = bucketCipher[b];
+            long long found = 0;
+            for (long long i = 0; i < n; i++){
+                int k = (int)(i % cipher.size());
+                found += wl.findCandidates(cipher[k], bucketUnknown[b][k]).size();
+            }
+            g_sink += found;
+            return n;
+        }});
+        benchmarks.push_back({string("WordList/countCandidates/bucket:") + bucketNames[b], [&, b](long long n){
+            const vector<string>& cipher = bucketCipher[b];
+            long long found = 0;
+            for (long long i = 0; i < n; i++){
+                int k = (int)(i % cipher.size());
+                found += wl.countCandidates(cipher[k], bucketUnknown[b][k]);
+            }
+            g_sink += found;
+            return n;
+        }});
+    }
+
+    // Lookups of words in the list, and of the same words scrambled, which almost never are
+    vector<string> hits;
+    vector<string> misses;
+    for (int i = 0; i < SAMPLE_WORDS && i < (int)order.size(); i++){
+        hits.push_back(words[order[i]]);
+        misses.push_back(encrypt(words[order[i]], rng));
+    }
+    benchmarks.push_back({"WordList/contains/hit", [&](long long n){
+        long long found = 0;
+        for (long long i = 0; i < n; i++){
+            found += wl.contains(hits[i % hits.size()]);
+        }
+        g_sink += found;
+        return n;
+    }});
+    benchmarks.push_back({"WordList/contains/miss", [&](long long n){
+        long long found = 0;
+        for (long long i = 0; i < n; i++){
+            found += wl.contains(misses[i % misses.size()]);
+        }
+        g_sink += found;
+        return n;
+    }});
+
+    //******************** MyHash ****************************************
+
+    benchmarks.push_back({"MyHash/associate", [&](long long n){
+        for (long long i = 0; i < n; i++){
+            MyHash<string, int> table;
+            for (int j = 0; j < (int)hits.size(); j++){
+                table.associate(hits[j], j);
+            }
+            g_sink += table.getNumItems();
+        }
+        return n * (long long)hits.size();
+    }});
+    MyHash<string, int> filled;
+    for (int j = 0; j < (int)hits.size(); j++){
+        filled.associate(hits[j], j);
+    }
+    benchmarks.push_back({"MyHash/find/hit", [&](long long n){
+        long long found = 0;
+        for (long long i = 0; i < n; i++){
+            found += filled.find(hits[i % hits.size()]) != nullptr;
+        }
+        g_sink += found;
+        return n;
+    }});
+    benchmarks.push_back({"MyHash/find/miss", [&](long long n){
+        long long found = 0;
+        for (long long i = 0; i < n; i++){
+            found += filled.find(misses[i % misses.size()]) != nullptr;
+        }
+        g_sink += found;
+        return n;
+    }});
+
+    //******************** MyOpenHash ****************************************
+
+    // WordList's table of letter patterns: filled with every distinct pattern in the list, looked up with the pattern
+    // of each ciphertext word.  Misses are patterns of random strings that no word in the list has
+    vector<PatternKey> patterns;
+    MyOpenHash<PatternKey, int, PatternKeyHash> patternTable;
+    for (int i = 0; i < (int)words.size(); i++){
+        PatternKey key;
+        if (getKey(words[i].data(), (int)words[i].size(), key) && patternTable.find(key) == nullptr){
+            patternTable.associate(key, (int)patterns.size());
+            patterns.push_back(key);
+        }
+    }
+    vector<PatternKey> patternHits;
+    for (int i = 0; i < (int)hits.size(); i++){
+        PatternKey key;
+        if (getKey(misses[i].data(), (int)misses[i].size(), key)){
+            patternHits.push_back(key);
+        }
+    }
+    vector<PatternKey> patternMisses;
+    for (int tries = 0; (int)patternMisses.size() < SAMPLE_WORDS && tries < 100 * SAMPLE_WORDS; tries++){
+        string s(4 + rng() % 16, 'a');
+        for (int j = 0; j < (int)s.size(); j++){
+            s[j] = (char)('a' + rng() % 8);
+        }
+        PatternKey key;
+        if (getKey(s.data(), (int)s.size(), key) && patternTable.find(key) == nullptr){
+            patternMisses.push_back(key);
+        }
+    }
+
+    benchmarks.push_back({"MyOpenHash/associate/patterns", [&](long long n){
+        for (long long i = 0; i < n; i++){
+            MyOpenHash<PatternKey, int, PatternKeyHash> table;
+            for (int j = 0; j < (int)patterns.size(); j++){
+                table.associate(patterns[j], j);
+            }
+            g_sink += table.getNumItems();
+        }
+        return n * (long long)patterns.size();
+    }});
+    if ( ! patternHits.empty()){
+        benchmarks.push_back({"MyOpenHash/find/patterns/hit", [&](long long n){
+            long long found = 0;
+            for (long long i = 0; i < n; i++){
+                found += patternTable.find(patternHits[i % patternHits.size()]) != nullptr;
+            }
+            g_sink += found;
+            return n;
+        }});
+    }
+    if ( ! patternMisses.empty()){
+        benchmarks.push_back({"MyOpenHash/find/patterns/miss", [&](long long n){
+            long long found = 0;
+            for (long long i = 0; i < n; i++){
+                found += patternTable.find(patternMisses[i % patternMisses.size()]) != nullptr;
+            }
+            g_sink += found;
+            return n;
+        }});
+    }
+
+    //******************** Translator ****************************************
+
+    // Push and pop the letters of one word at a time, as the search does
+    vector<string> plainMappings;
+    vector<string> cipherMappings;
+    for (int i = 0; i < (int)hits.size(); i++){
+        string letters;
+        for (int j = 0; j < (int)hits[i].size(); j++){
+            char c = tolower(hits[i][j]);
+            if (isalpha(c) && letters.find(c) == string::npos){
+                letters += c;
+            }
+        }
+        plainMappings.push_back(letters);
+        cipherMappings.push_back(encrypt(letters, rng));
+    }
+    benchmarks.push_back({"Translator/pushMapping+popMapping", [&](long long n){
+        Translator t;
+        long long pushed = 0;
+        for (long long i = 0; i < n; i++){
+            int k = (int)(i % plainMappings.size());
+            if (t.pushMapping(cipherMappings[k], plainMappings[k])){
+                pushed++;
+                t.popMapping();
+            }
+        }
+        g_sink += pushed;
+        return n;
+    }});
+
+    // A long text, made of the sample words, to tokenize and translate
+    string text;
+    while (text.size() < 64 * 1024){
+        text += hits[rng() % hits.size()];
+        const char* separators[] = {" ", " ", " ", ", ", ". ", "! ", "? ", "\n"};
+        text += separators[rng() % 8];
+    }
+    Translator fullKey;
+    fullKey.pushMapping("abcdefghijklmnopqrstuvwxyz", encrypt("abcdefghijklmnopqrstuvwxyz", rng));
+    benchmarks.push_back({"Translator/getTranslation/64KiB", [&](long long n){
+        for (long long i = 0; i < n; i++){
+            g_sink += fullKey.getTranslation(text).size();
+        }
+        return n * (long long)text.size();
+    }});
+
+    //******************** Tokenizer ****************************************
+
+    Tokenizer tokenizer(" ,;:.!()[]{}-\"#$%^&\n\t?");
+    benchmarks.push_back({"Tokenizer/tokenize/strings/64KiB", [&](long long n){
+        for (long long i = 0; i < n; i++){
+            g_sink += tokenizer.tokenize(text).size();
+        }
+        return n * (long long)text.size();
+    }});
+    benchmarks.push_back({"Tokenizer/tokenize/views/64KiB", [&](long long n){
+        vector<string_view> tokens;
+        for (long long i = 0; i < n; i++){
+            tokenizer.tokenize(text, tokens);
+            g_sink += tokens.size();
+        }
+        return n * (long long)text.size();
+    }});
+
+    //******************** Decrypter ****************************************
+
+    // Whole cracks of messages of common-length words, without the cache so every iteration does the search
+    shared_ptr<WordList> shared = make_shared<WordList>();
+    shared->loadWordList(haveIndex ? indexFile : filename);
+    Decrypter decrypter(shared);
+    CrackOptions uncached;
+    uncached.useCache = false;
+    // Longer words pin the key down quickly, so messages of any length stay quick to crack.  A list without any
+    // would make messages that could take arbitrarily long, so the cracks are skipped instead
+    vector<string> longWords;
+    for (int i = 0; i < (int)hits.size(); i++){
+        if (hits[i].size() >= 7){
+            longWords.push_back(hits[i]);
+        }
+    }
+    if (longWords.empty()){
+        cerr << "No sampled word has 7 or more letters, skipping the Decrypter/crack benchmarks" << endl;
+    }
+    for (int nWords : {4, 8, 16, 32}){
+        if (longWords.empty()){
+            break;
+        }
+        string message;
+        for (int i = 0; i < nWords; i++){
+            message += (i == 0 ? "" : " ") + longWords[rng() % longWords.size()];
+        }
+        string cipher = encrypt(message, rng);
+        benchmarks.push_back({"Decrypter/crack/words:" + to_string(nWords), [&, cipher](long long n){
+            for (long long i = 0; i < n; i++){
+                g_sink += decrypter.crack(cipher, uncached).size();
+            }
+            return n;
+        }});
+    }
+
+    vector<Result> results;
+    for (int i = 0; i < (int)benchmarks.size(); i++){
+        if (benchmarks[i].name.find(filter) == string::npos){
+            continue;
+        }
+        Result r = runBenchmark(benchmarks[i], minSeconds);
+        cerr << r.name << ": " << r.realNs << " ns/iteration over " << r.iterations << " iterations" << endl;
+        results.push_back(r);
+    }
+
+    if (haveIndex){
+        remove(indexFile.c_str());
+    }
+    writeJson(cout, argv[0], filename, results);
+    return 0;
+}
@@ -0,0 +1,128 @@
+// HashBench.cpp
+
+// Compares the chained MyHash against the open-addressing MyOpenHash on the real word list.
+// Both tables are filled with the letter pattern of every word, then probed with every word's pattern (all hits) and
+// with patterns that are almost all misses.  Each table is timed with the patterns written out as strings, and with
+// the packed PatternKey that WordList actually uses.
+//
+// Usage: hashbench [wordlist.txt] [rounds]
+
+#include "MyHash.h"
+#include "MyOpenHash.h"
+#include "PatternKey.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cctype>
+using namespace std;
+
+// MyHash takes its hash through a free function
+unsigned int hash(const std::string& s)
+{
+    return (int)std::hash<std::string>()(s);
+}
+
+unsigned int hash(const PatternKey& key)
+{
+    return (unsigned int)PatternKeyHash()(key);
+}
+
+// A word's letter pattern written out as a string, "hello" is ABCCE
+string patternOf(const string& s)
+{
+    string key;
+    for (int i = 0; i < (int)s.size(); i++){
+        if (s[i] == '\''){
+            key += '\'';
+            continue;
+        }
+        key += ('A' + i);
+        for (int j = 0; j < i; j++){
+            if (tolower(s[i]) == tolower(s[j])){
+                key[i] = key[j];
+                break;
+            }
+        }
+    }
+    return key;
+}
+
+template<typename Table, typename KeyType>
+void runTable(const string& name, const vector<KeyType>& keys, const vector<KeyType>& misses, int rounds)
+{
+    double insertMs = 0, hitMs = 0, missMs = 0;
+    long long found = 0;
+    
+    for (int r = 0; r < rounds; r++){
+        Table t;
+        
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < (int)keys.size(); i++){
+            t.associate(keys[i], i);
+        }
+        auto inserted = chrono::steady_clock::now();
+        for (int i = 0; i < (int)keys.size(); i++){
+            found += (t.find(keys[i]) != nullptr);
+        }
+        auto hits = chrono::steady_clock::now();
+        for (int i = 0; i < (int)misses.size(); i++){
+            found += (t.find(misses[i]) != nullptr);
+        }
+        auto done = chrono::steady_clock::now();
+        
+        insertMs += chrono::duration<double, milli>(inserted - start).count();
+        hitMs += chrono::duration<double, milli>(hits - inserted).count();
+        missMs += chrono::duration<double, milli>(done - hits).count();
+    }
+    
+    cout << name << ": insert " << insertMs / rounds << " ms, "
+         << "hit lookups " << hitMs / rounds * 1e6 / keys.size() << " ns each, "
+         << "miss lookups " << missMs / rounds * 1e6 / misses.size() << " ns each"
+         << " (" << found << " found)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    int rounds = argc > 2 ? stoi(argv[2]) : 5;
+    
+    ifstream in(filename);
+    if ( ! in){
+        cerr << "Unable to load word list file " << filename << endl;
+        return 1;
+    }
+    
+    // The string misses are the words themselves.  The PatternKey misses are the patterns of each word written twice
+    // with an apostrophe between, which no real word has
+    vector<string> keys;
+    vector<string> misses;
+    vector<PatternKey> packedKeys;
+    vector<PatternKey> packedMisses;
+    string word;
+    while (getline(in, word)){
+        // Only the word, if the line also has a frequency
+        word = word.substr(0, word.find_first_of(" \t\r"));
+        keys.push_back(patternOf(word));
+        misses.push_back(word);
+        
+        PatternKey key;
+        if (getKey(word.data(), (int)word.size(), key)){
+            packedKeys.push_back(key);
+        }
+        string doubled = word + "'" + word;
+        if (getKey(doubled.data(), (int)doubled.size(), key)){
+            packedMisses.push_back(key);
+        }
+    }
+    
+    cout << keys.size() << " words, " << rounds << " rounds" << endl;
+    runTable<MyHash<string, int>>("MyHash (chained), string patterns", keys, misses, rounds);
+    runTable<MyOpenHash<string, int>>("MyOpenHash (SwissTable-style), string patterns", keys, misses, rounds);
+    runTable<MyHash<PatternKey, int>>("MyHash (chained), PatternKey", packedKeys, packedMisses, rounds);
+    runTable<MyOpenHash<PatternKey, int, PatternKeyHash>>("MyOpenHash (SwissTable-style), PatternKey", packedKeys,
+                                                          packedMisses, rounds);
+    return 0;
+}
@@ -1,15 +1,62 @@
+// Usage: decrypter [options]
+//
+// With no --batch or --input, asks for one message, optionally encrypts it, and prints every translation.
+// Otherwise cracks one ciphertext per line (or per NUL-terminated record with --null) of the input, and writes one
+// JSON object per ciphertext, in input order, to standard output:
+//   {"index":0,"ciphertext":"...","status":"complete","count":2,"ms":1.25,"solutions":["...","..."]}
+// The word list is loaded once, and reading, cracking on a pool of workers and writing all overlap.  Only a few
+// ciphertexts per worker are held at any time, so the input can be far larger than memory.
+//
+//   --dict PATH         word list, text or binary index (default wordlist.txt)
+//   --input PATH        read ciphertexts from PATH, - for standard input
+//   --batch             read ciphertexts from standard input
+//   --null              ciphertexts end with NUL instead of newline
+//   --workers N         ciphertexts cracked at once (default one per hardware thread)
+//   --threads N         threads each crack searches with (default 1)
+//   --first N           stop each crack after N solutions
+//   --count             only count each ciphertext's solutions (not with --first)
+//   --timeout-ms N      give up on a ciphertext after N milliseconds
+//   --max-nodes N       give up on a ciphertext after N search nodes
+//   --stats             print search statistics for the whole run to standard error at the end
+
 #include "provided.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <cctype>
+#include <cstdlib>
 #include <random>
 #include <algorithm>
 #include <numeric>
 using namespace std;
 
-const string WORDLIST_FILE = "/Users/adamgriffin/Desktop/CS 32/Project 4/Project 4/wordlist.txt";
+// Ciphertexts read but not yet written, per worker.  Bounds the memory a batch uses, however long the input
+const int RECORDS_PER_WORKER = 4;
+
+struct CliOptions
+{
+    string dictionary = "wordlist.txt";
+    bool batch = false;
+    string input = "-";
+    char delimiter = '\n';
+    int workers = 0;
+    int threads = 1;
+    int first = 0;                  // 0 for every solution
+    bool countOnly = false;
+    long long timeoutMs = 0;        // 0 for no limit
+    long long maxNodes = 0;
+    bool stats = false;
+};
 
 // Encrypt plaintext string with random substitution permutation
 string encrypt(string plaintext)
@@ -31,26 +78,262 @@ string encrypt(string plaintext)
 }
 
 // Decrypt cipertext into all possible permutations
-bool decrypt(string ciphertext, int& count)
+bool decrypt(string ciphertext, const string& dictionary, int& count)
 {
     Decrypter d;
-    if ( ! d.load(WORDLIST_FILE))
+    if ( ! d.load(dictionary))
     {
         // If not able to load list of words
-        cout << "Unable to load word list file " << WORDLIST_FILE << endl;
+        cout << "Unable to load word list file " << dictionary << endl;
         return false;
     }
     
-    // Crack text to produce all possible translations
-    for (const auto& s : d.crack(ciphertext)){
-        cout << s << endl;
+    // Crack text to produce all possible translations, printing each one as it's delivered rather than holding them
+    // all in memory
+    CrackOptions options;
+    options.sorted = true;
+    d.crack(ciphertext, [&count](const string& s){
+        cout << s << '\n';
         // Count number of translations
         count++;
-    }
+        return true;
+    }, options);
     return true;
 }
 
-int main()
+// Length of the well-formed UTF-8 sequence starting at s[i], or 0 if there isn't one there.  Overlong encodings,
+// surrogates and code points past U+10FFFF aren't well-formed
+int utf8Length(const string& s, int i)
+{
+    unsigned char c = s[i];
+    int length;
+    unsigned char low = 0x80;       // Range of the second byte
+    unsigned char high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF){
+        length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF){
+        length = 3;
+        if (c == 0xE0){
+            low = 0xA0;
+        } else if (c == 0xED){
+            high = 0x9F;
+        }
+    } else if (c >= 0xF0 && c <= 0xF4){
+        length = 4;
+        if (c == 0xF0){
+            low = 0x90;
+        } else if (c == 0xF4){
+            high = 0x8F;
+        }
+    } else {
+        return 0;
+    }
+    
+    if (i + length > (int)s.size()){
+        return 0;
+    }
+    for (int j = 1; j < length; j++){
+        unsigned char next = s[i + j];
+        if (next < (j == 1 ? low : 0x80) || next > (j == 1 ? high : 0xBF)){
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Quote s as a JSON string.  Ciphertexts are arbitrary bytes, so control characters are escaped, well-formed UTF-8 is
+// passed through as is, and any other byte is escaped as the Latin-1 character it would be, so the line is always
+// valid JSON
+string jsonString(const string& s)
+{
+    string out = "\"";
+    for (int i = 0; i < (int)s.size(); i++){
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\'){
+            out += '\\';
+            out += (char)c;
+        } else if (c == '\n'){
+            out += "\\n";
+        } else if (c == '\t'){
+            out += "\\t";
+        } else if (c == '\r'){
+            out += "\\r";
+        } else if (c < 0x20){
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else if (c < 0x80){
+            out += (char)c;
+        } else {
+            int length = utf8Length(s, i);
+            if (length > 0){
+                out.append(s, i, length);
+                i += length - 1;
+            } else {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+const char* statusName(CrackStatus status)
+{
+    switch (status){
+        case CrackStatus::Complete:     return "complete";
+        case CrackStatus::Stopped:      return "stopped";
+        case CrackStatus::TimedOut:     return "timed_out";
+        case CrackStatus::NodeLimit:    return "node_limit";
+        case CrackStatus::Cancelled:    return "cancelled";
+        case CrackStatus::WriteFailed:  return "write_failed";
+    }
+    return "unknown";
+}
+
+// Crack one ciphertext as the options say, and describe the result as one line of JSON
+string crackRecord(Decrypter& decrypter, const CliOptions& cli, size_t index, const string& ciphertext)
+{
+    CrackOptions options;
+    options.threads = cli.threads;
+    options.maxNodes = cli.maxNodes;
+    auto start = chrono::steady_clock::now();
+    if (cli.timeoutMs > 0){
+        options.deadline = start + chrono::milliseconds(cli.timeoutMs);
+    }
+
+    CrackStatus status;
+    vector<string> solutions;
+    long long count;
+    if (cli.countOnly){
+        count = decrypter.crackCount(ciphertext, options, &status);
+    } else {
+        solutions = cli.first > 0 ? decrypter.crackFirst(ciphertext, cli.first, options, &status)
+                                  : decrypter.crack(ciphertext, options, &status);
+        count = (long long)solutions.size();
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    ostringstream out;
+    out << "{\"index\":" << index << ",\"ciphertext\":" << jsonString(ciphertext) << ",\"status\":\"" << statusName(status)
+        << "\",\"count\":" << count << ",\"ms\":" << ms;
+    if ( ! cli.countOnly){
+        out << ",\"solutions\":[";
+        for (int i = 0; i < (int)solutions.size(); i++){
+            out << (i == 0 ? "" : ",") << jsonString(solutions[i]);
+        }
+        out << "]";
+    }
+    out << "}\n";
+    return out.str();
+}
+
+// Crack every record of the input on a pool of workers.  One thread reads records into a bounded queue, the workers
+// crack them, and whichever worker finishes the next record due writes it and any finished records after it, so the
+// output is in input order.  The reader waits whenever RECORDS_PER_WORKER records per worker are read but not yet
+// written, which bounds both the queue and the records waiting for an earlier one
+int runBatch(const CliOptions& cli)
+{
+    // Load the word list once, for every worker to share
+    shared_ptr<WordList> wl = make_shared<WordList>();
+    if ( ! wl->loadWordList(cli.dictionary)){
+        cerr << "Unable to load word list file " << cli.dictionary << endl;
+        return 1;
+    }
+    Decrypter decrypter(wl);
+    decrypter.setCollectStats(cli.stats);
+
+    ifstream file;
+    istream* in = &cin;
+    if (cli.input != "-"){
+        file.open(cli.input, ios::binary);
+        if ( ! file){
+            cerr << "Unable to open input file " << cli.input << endl;
+            return 1;
+        }
+        in = &file;
+    }
+
+    int workers = cli.workers > 0 ? cli.workers : max(1, (int)thread::hardware_concurrency());
+    size_t window = (size_t)workers * RECORDS_PER_WORKER;
+
+    mutex lock;
+    condition_variable roomToRead;
+    condition_variable recordReady;
+    deque<pair<size_t, string>> queue;      // Records read but not yet taken by a worker
+    map<size_t, string> finished;           // Results waiting for an earlier record to be written
+    size_t nRead = 0;
+    size_t nWritten = 0;
+    bool inputDone = false;
+
+    thread reader([&](){
+        string record;
+        while (getline(*in, record, cli.delimiter)){
+            if (cli.delimiter == '\n' && ! record.empty() && record.back() == '\r'){
+                // Lines from Windows files
+                record.pop_back();
+            }
+            unique_lock<mutex> guard(lock);
+            roomToRead.wait(guard, [&](){ return nRead - nWritten < window; });
+            queue.push_back(make_pair(nRead++, move(record)));
+            recordReady.notify_one();
+        }
+        lock_guard<mutex> guard(lock);
+        inputDone = true;
+        recordReady.notify_all();
+    });
+
+    vector<thread> pool;
+    for (int t = 0; t < workers; t++){
+        pool.push_back(thread([&](){
+            for (;;){
+                pair<size_t, string> record;
+                {
+                    unique_lock<mutex> guard(lock);
+                    recordReady.wait(guard, [&](){ return ! queue.empty() || inputDone; });
+                    if (queue.empty()){
+                        return;
+                    }
+                    record = move(queue.front());
+                    queue.pop_front();
+                }
+
+                string result = crackRecord(decrypter, cli, record.first, record.second);
+
+                lock_guard<mutex> guard(lock);
+                finished[record.first] = move(result);
+                while ( ! finished.empty() && finished.begin()->first == nWritten){
+                    cout << finished.begin()->second;
+                    finished.erase(finished.begin());
+                    nWritten++;
+                }
+                roomToRead.notify_one();
+            }
+        }));
+    }
+
+    reader.join();
+    for (int t = 0; t < workers; t++){
+        pool[t].join();
+    }
+    cout.flush();
+
+    if (cli.stats){
+        CrackStats s = decrypter.stats();
+        cerr << "{\"records\":" << nWritten << ",\"searches\":" << s.searches << ",\"nodes\":" << s.nodes
+             << ",\"findCandidatesCalls\":" << s.findCandidatesCalls << ",\"candidates\":" << s.candidates
+             << ",\"countCandidatesCalls\":" << s.countCandidatesCalls << ",\"pushConflicts\":" << s.pushConflicts
+             << ",\"rejections\":" << s.rejections << ",\"pruned\":" << s.pruned << ",\"nogoodHits\":" << s.nogoodHits
+             << ",\"maxDepth\":" << s.maxDepth << ",\"solutions\":" << s.solutions
+             << ",\"loadSeconds\":" << s.loadSeconds << ",\"tokenizeSeconds\":" << s.tokenizeSeconds
+             << ",\"candidateSeconds\":" << s.candidateSeconds << ",\"verifySeconds\":" << s.verifySeconds << "}" << endl;
+    }
+    return cout ? 0 : 1;
+}
+
+// Prompt for one message, like the original program
+int runInteractive(const CliOptions& cli)
 {
     // Encrypt the message being entered? Anything besides 'y' means no
     cout << "Encrypt the message first? (y/n) ";
@@ -69,7 +352,67 @@ int main()
     
     cout << "Possible translations:" << "\n\n";
     int count = 0;
-    decrypt(message, count);
+    if ( ! decrypt(message, cli.dictionary, count)){
+        return 1;
+    }
     cout << "\nThere are " << count << " possible translations." << endl;
+    return 0;
 }
 
+void printUsage(const char* program)
+{
+    cerr << "Usage: " << program << " [--dict PATH] [--input PATH | --batch] [--null] [--workers N] [--threads N]"
+         << " [--first N | --count] [--timeout-ms N] [--max-nodes N] [--stats]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    CliOptions cli;
+    bool firstGiven = false;
+    for (int i = 1; i < argc; i++){
+        string arg = argv[i];
+        // Options that take a value
+        bool hasValue = i + 1 < argc;
+        if (arg == "--dict" && hasValue){
+            cli.dictionary = argv[++i];
+        } else if (arg == "--input" && hasValue){
+            cli.input = argv[++i];
+            cli.batch = true;
+        } else if (arg == "--workers" && hasValue){
+            cli.workers = atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue){
+            cli.threads = atoi(argv[++i]);
+        } else if (arg == "--first" && hasValue){
+            cli.first = atoi(argv[++i]);
+            firstGiven = true;
+        } else if (arg == "--timeout-ms" && hasValue){
+            cli.timeoutMs = atoll(argv[++i]);
+        } else if (arg == "--max-nodes" && hasValue){
+            cli.maxNodes = atoll(argv[++i]);
+        } else if (arg == "--batch"){
+            cli.batch = true;
+        } else if (arg == "--null"){
+            cli.delimiter = '\0';
+        } else if (arg == "--count"){
+            cli.countOnly = true;
+        } else if (arg == "--stats"){
+            cli.stats = true;
+        } else {
+            cerr << "Unknown or incomplete option " << arg << endl;
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    
+    // Counting never builds a solution, so there would be nothing for --first to keep
+    if (firstGiven && cli.countOnly){
+        cerr << "--first and --count can't be used together" << endl;
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (cli.batch){
+        return runBatch(cli);
+    }
+    return runInteractive(cli);
+}
@@ -2,7 +2,13 @@
 #define PROVIDED_INCLUDED
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
+#include <cstddef>
+#include <chrono>
+#include <atomic>
+#include <memory>
 
 
 /*
@@ -18,6 +24,8 @@ public:
     Tokenizer(std::string separators);
     ~Tokenizer();
     std::vector<std::string> tokenize(const std::string& s) const;
+    // Views into s of the tokens, without copying any of them
+    void tokenize(std::string_view s, std::vector<std::string_view>& tokens) const;
     // Tokenizer objects cannot be copied or assigned
     Tokenizer(const Tokenizer&) = delete;
     Tokenizer& operator=(const Tokenizer&) = delete;
@@ -33,8 +41,24 @@ public:
     WordList();
     ~WordList();
     bool loadWordList(std::string filename);
-    bool contains(std::string word) const;
+    // Threads to load large text files with, 0 (the default) for one per hardware thread.
+    // The loaded list is the same whatever the number of threads
+    void setLoadThreads(int nThreads);
+    bool saveIndex(std::string filename) const;
+    bool contains(std::string_view word) const;
+    // Log probability of the word from the frequencies in the list, returns false if the word isn't in the list
+    bool logProbability(std::string_view word, double& logProb) const;
+    // Log probabilities of the letter quadgrams of the words in the list, counting the edge of a word as a 27th
+    // symbol.  Quadgram a b c d is at ((a * 27 + b) * 27 + c) * 27 + d, with letters 0-25 and 26 for the edge.
+    // Built the first time it's asked for, and good until the next load
+    const float* quadgramTable() const;
     std::vector<std::string> findCandidates(std::string cipherWord, std::string currTranslation) const;
+    int countCandidates(std::string cipherWord, std::string currTranslation) const;
+    // The same, with what each cipher letter may still be given as a set of plaintext letters: bit p of domains[c]
+    // is set if cipher letter 'A' + c can be plaintext letter 'a' + p.  countCandidates also ORs into supports[c]
+    // (unless it's nullptr) the letters the matching words give cipher letter c
+    std::vector<std::string> findCandidates(std::string_view cipherWord, const unsigned int domains[26]) const;
+    int countCandidates(std::string_view cipherWord, const unsigned int domains[26], unsigned int supports[26] = nullptr) const;
     // WordList objects cannot be copied or assigned
     WordList(const WordList&) = delete;
     WordList& operator=(const WordList&) = delete;
@@ -49,7 +73,7 @@ class Translator
 public:
     Translator();
     ~Translator();
-    bool pushMapping(std::string ciphertext, std::string plaintext);
+    bool pushMapping(const std::string& ciphertext, const std::string& plaintext);
     bool popMapping();
     std::string getTranslation(const std::string& ciphertext) const;
     // Translator objects cannot be copied or assigned
@@ -61,13 +85,141 @@ private:
 
 class DecrypterImpl;
 
+// Options for Decrypter::crack
+struct CrackOptions
+{
+    // Number of threads to search with, 0 for one per hardware thread.
+    // The solutions are the same, in the same order, whatever the number of threads
+    int threads = 1;
+
+    // Streaming crack only: deliver the solutions in alphabetical order.  They are held in memory up to
+    // sortBufferBytes, then spilled to sorted temporary files that are merged once the search finishes
+    bool sorted = false;
+    std::size_t sortBufferBytes = 64 << 20;
+
+    // Limits on the search.  Once one is reached the search stops and the solutions found so far are returned.
+    // The deadline is checked every few hundred search nodes, and with several threads maxNodes can be overshot by
+    // that much per thread.  0 for maxNodes, or no cancel flag, means no limit
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    long long maxNodes = 0;
+    const std::atomic<bool>* cancel = nullptr;     // The search stops soon after this is set to true
+
+    // Look up the Decrypter's result cache, and store complete results in it
+    bool useCache = true;
+
+    // crackBest only: the most partial solutions kept waiting to be explored, 0 for no limit.  A limit bounds the
+    // memory the search uses, but then the solutions are only likely, not guaranteed to be the most likely
+    int beamWidth = 0;
+
+    // crackQuadgram only: how many climbs to run from random keys, and the seed their keys come from.
+    // The same seed and number of restarts always give the same result
+    int restarts = 32;
+    unsigned int seed = 1;
+};
+
+// How a crack ended
+enum class CrackStatus
+{
+    Complete,       // Every solution was found
+    Stopped,        // The solution callback asked to stop, or crackFirst found more solutions than asked for
+    TimedOut,       // The deadline passed
+    NodeLimit,      // The search reached maxNodes
+    Cancelled,      // The cancel flag was set
+    WriteFailed     // A sorted crack couldn't write a temporary file, so it stopped with the solutions it could keep
+};
+
+// Called with each solution as it is found, returns false to stop the search
+typedef std::function<bool(const std::string& solution)> SolutionCallback;
+
+// Counters of a Decrypter's result cache
+struct CacheStats
+{
+    long long hits = 0;
+    long long misses = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;      // Estimated memory held by the cached results
+};
+
+// Counters and phase timers of a Decrypter's exhaustive searches (crack, crackCount, crackFirst and crackBatch),
+// summed over every search since they were last reset.  Only collected while setCollectStats(true) is in effect,
+// and never if the library is built with DECRYPTER_NO_STATS defined, which compiles the counting out altogether
+struct CrackStats
+{
+    long long searches = 0;                 // Cracks that searched, rather than finding their result in the cache
+    long long nodes = 0;                    // Search nodes expanded
+    long long findCandidatesCalls = 0;
+    long long candidates = 0;               // Total candidates those calls returned
+    long long countCandidatesCalls = 0;     // Made to pick the word with the fewest candidates
+    long long pushConflicts = 0;            // Candidates whose letters clashed with the mapping so far
+    long long rejections = 0;               // Candidates that fully translated some word into one not in the list
+    long long pruned = 0;                   // Candidates that left some word or letter with no possibilities
+    long long nogoodHits = 0;               // Nodes skipped because the same state had already led nowhere
+    int maxDepth = 0;                       // Most words chosen on any path of the search
+    long long solutions = 0;
+
+    // Seconds spent in each phase.  The candidate and verify times are summed over the threads of a search
+    double loadSeconds = 0;
+    double tokenizeSeconds = 0;
+    double candidateSeconds = 0;            // In findCandidates and countCandidates
+    double verifySeconds = 0;               // Checking the words a choice fully translated against the list
+};
+
+// A solution of crackBest, with the log probability of its words according to the word list's frequencies, or of
+// crackQuadgram, with the log probability of its quadgrams
+struct ScoredSolution
+{
+    std::string solution;
+    double logProb = 0;
+};
+
+// The result of cracking one ciphertext of a batch
+struct BatchResult
+{
+    std::size_t index = 0;                  // Position of the ciphertext in the batch
+    std::vector<std::string> solutions;     // In alphabetical order
+    CrackStatus status = CrackStatus::Complete;
+};
+
 class Decrypter
 {
 public:
     Decrypter();
+    // Cracks with a list that's already loaded, which can be shared by any number of Decrypters and threads
+    Decrypter(std::shared_ptr<const WordList> wordList);
     ~Decrypter();
     bool load(std::string filename);
     std::vector<std::string> crack(const std::string& ciphertext);
+    std::vector<std::string> crack(const std::string& ciphertext, const CrackOptions& options, CrackStatus* status = nullptr);
+    CrackStatus crack(const std::string& ciphertext, const SolutionCallback& onSolution, const CrackOptions& options = CrackOptions());
+    // Number of solutions, without building any of them
+    long long crackCount(const std::string& ciphertext, const CrackOptions& options = CrackOptions(), CrackStatus* status = nullptr);
+    // At most n solutions.  The search stops when it finds one more than n, so the status is Complete if the message
+    // has no more than n solutions and Stopped if it has more
+    std::vector<std::string> crackFirst(const std::string& ciphertext, int n, const CrackOptions& options = CrackOptions(),
+                                        CrackStatus* status = nullptr);
+    // The k likeliest solutions, likeliest first, found best-first without going through the others
+    std::vector<ScoredSolution> crackBest(const std::string& ciphertext, int k, const CrackOptions& options = CrackOptions(),
+                                          CrackStatus* status = nullptr);
+    // The likeliest plaintext by quadgram statistics, found by hill climbing over keys.  Doesn't need every word to be
+    // in the list, so it suits long messages with names or typos, but isn't guaranteed to find the best key.
+    // Stops at the deadline or when cancelled, with the best key so far
+    ScoredSolution crackQuadgram(const std::string& ciphertext, const CrackOptions& options = CrackOptions(),
+                                 CrackStatus* status = nullptr);
+    // Cracks many ciphertexts on a pool of worker threads (0 for one per hardware thread), each ciphertext with the
+    // given options.  The first takes ciphertexts from nextCiphertext until it returns false and hands each result
+    // to onResult as soon as it is ready, in any order; the second returns the results in the order of ciphertexts
+    void crackBatch(const std::function<bool(std::string& ciphertext)>& nextCiphertext,
+                    const std::function<void(BatchResult& result)>& onResult,
+                    const CrackOptions& options = CrackOptions(), int workers = 0);
+    std::vector<BatchResult> crackBatch(const std::vector<std::string>& ciphertexts,
+                                        const CrackOptions& options = CrackOptions(), int workers = 0);
+    // Results are cached up to this many bytes (0 turns the cache off), least recently used results are dropped first
+    void setCacheBudget(std::size_t bytes);
+    CacheStats cacheStats() const;
+    // Statistics cost a few counters and clock reads per search node, so they are off until asked for
+    void setCollectStats(bool collect);
+    CrackStats stats() const;
+    void resetStats();
     // Decrypter objects cannot be copied or assigned
     Decrypter(const Decrypter&) = delete;
     Decrypter& operator=(const Decrypter&) = delete;
@@ -0,0 +1,95 @@
+// IndexTest.cpp
+
+// Checks that WordList::loadWordList rejects binary indexes whose header doesn't fit the file: truncated files, and
+// word and bucket counts so large that adding up the sizes of the parts would wrap around.  Every index is made from
+// a small word list written to the temporary directory.
+//
+// Usage: indextest
+// Exits with 0 if every check passes.
+
+#include "provided.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+using namespace std;
+
+// Where loadIndex reads the header fields, as laid out by WordList.cpp's IndexHeader
+const size_t HEADER_BYTES = 24;
+const size_t N_BUCKETS_OFFSET = 12;
+const size_t WORD_BYTES_OFFSET = 16;
+
+int g_failures = 0;
+
+string readFile(const string& filename)
+{
+    ifstream in(filename, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void writeFile(const string& filename, const string& contents)
+{
+    ofstream out(filename, ios::binary | ios::trunc);
+    out.write(contents.data(), contents.size());
+}
+
+void expectLoad(const string& name, const string& filename, const string& contents, bool expected)
+{
+    writeFile(filename, contents);
+    WordList wl;
+    bool loaded = wl.loadWordList(filename);
+    if (loaded != expected){
+        cerr << "FAIL " << name << ": loadWordList returned " << loaded << endl;
+        g_failures++;
+    } else {
+        cerr << "ok   " << name << endl;
+    }
+}
+
+template<typename T>
+string withField(string index, size_t offset, T value)
+{
+    memcpy(&index[offset], &value, sizeof(value));
+    return index;
+}
+
+int main()
+{
+    filesystem::path dir = filesystem::temp_directory_path();
+    string textFile = (dir / "indextest-words.txt").string();
+    string indexFile = (dir / "indextest-words.idx").string();
+    string badFile = (dir / "indextest-bad.idx").string();
+
+    writeFile(textFile, "hello\nworld\ndon't\nthe\na\nbanana\n");
+    WordList wl;
+    if ( ! wl.loadWordList(textFile) || ! wl.saveIndex(indexFile)){
+        cerr << "Unable to build the test index" << endl;
+        return 1;
+    }
+    string index = readFile(indexFile);
+
+    expectLoad("intact index", badFile, index, true);
+    expectLoad("truncated inside the header", badFile, index.substr(0, HEADER_BYTES - 1), false);
+    expectLoad("header only", badFile, index.substr(0, HEADER_BYTES), false);
+    expectLoad("truncated inside the words", badFile, index.substr(0, index.size() / 2), false);
+    expectLoad("one byte short", badFile, index.substr(0, index.size() - 1), false);
+    expectLoad("one byte over", badFile, index + '\0', false);
+    expectLoad("wordBytes 2^63", badFile, withField(index, WORD_BYTES_OFFSET, 1ULL << 63), false);
+    expectLoad("wordBytes wraps to the file size", badFile,
+               withField(index, WORD_BYTES_OFFSET, (0ULL - index.size()) / 2 + 1), false);
+    expectLoad("wordBytes all ones", badFile, withField(index, WORD_BYTES_OFFSET, ~0ULL), false);
+    expectLoad("nBuckets all ones", badFile, withField(index, N_BUCKETS_OFFSET, ~0U), false);
+
+    remove(textFile.c_str());
+    remove(indexFile.c_str());
+    remove(badFile.c_str());
+
+    if (g_failures > 0){
+        cerr << g_failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cerr << "All checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,94 @@
+// MyHashTest.cpp
+
+// Checks that MyHash keeps every item when inserts grow the table.  An insert that grows the table has to put its
+// new item in the bucket for the new number of buckets, or finding it later looks in the wrong bucket.
+//
+// Usage: myhashtest
+// Exits with 0 if every check passes.
+
+#include "MyHash.h"
+#include <iostream>
+#include <string>
+#include <functional>
+using namespace std;
+
+// MyHash takes its hash through a free function
+unsigned int hash(const int& i)
+{
+    return (unsigned int)i * 2654435761u;
+}
+
+unsigned int hash(const std::string& s)
+{
+    return (unsigned int)std::hash<std::string>()(s);
+}
+
+int g_failures = 0;
+
+void check(const string& name, bool passed)
+{
+    if ( ! passed){
+        cerr << "FAIL " << name << endl;
+        g_failures++;
+    } else {
+        cerr << "ok   " << name << endl;
+    }
+}
+
+// Inserts keys one at a time, then checks every key is found with its value and nothing else is
+template<typename KeyType>
+void checkInserts(const string& name, double maxLoadFactor, int n, function<KeyType(int)> keyOf)
+{
+    MyHash<KeyType, int> table(maxLoadFactor);
+    for (int i = 0; i < n; i++){
+        table.associate(keyOf(i), i);
+    }
+
+    bool allFound = true;
+    for (int i = 0; i < n; i++){
+        const int* value = table.find(keyOf(i));
+        if (value == nullptr || *value != i){
+            allFound = false;
+        }
+    }
+    check(name + ": every key found", allFound);
+    check(name + ": item count", table.getNumItems() == n);
+    check(name + ": load factor kept", table.getLoadFactor() <= maxLoadFactor);
+    check(name + ": missing key not found", table.find(keyOf(n)) == nullptr);
+
+    // Updating every key again must change values, not add items
+    for (int i = 0; i < n; i++){
+        table.associate(keyOf(i), -i);
+    }
+    bool allUpdated = true;
+    for (int i = 0; i < n; i++){
+        const int* value = table.find(keyOf(i));
+        if (value == nullptr || *value != -i){
+            allUpdated = false;
+        }
+    }
+    check(name + ": every key updated", allUpdated);
+    check(name + ": item count after updates", table.getNumItems() == n);
+}
+
+int main()
+{
+    // The table starts with 100 buckets, so these all grow it several times
+    for (double load : {0.5, 1.0, 2.0}){
+        string suffix = " at load " + to_string(load);
+        checkInserts<int>("int keys" + suffix, load, 5000, [](int i){ return i; });
+        checkInserts<string>("string keys" + suffix, load, 5000, [](int i){ return "key" + to_string(i); });
+    }
+
+    // Right up to and just past the first growth
+    for (int n : {49, 50, 51, 52, 101}){
+        checkInserts<int>("int keys, " + to_string(n) + " items", 0.5, n, [](int i){ return i * 7; });
+    }
+
+    if (g_failures > 0){
+        cerr << g_failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cerr << "All checks passed" << endl;
+    return 0;
+}
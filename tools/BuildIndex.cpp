@@ -0,0 +1,32 @@
+// BuildIndex.cpp
+
+// Converts a text word list (one word per line) into the binary index that WordList::loadWordList maps straight into
+// memory.  Decrypter::load accepts either file, so the index can simply be passed in place of wordlist.txt.
+//
+// Usage: buildindex <wordlist.txt> <wordlist.idx>
+
+#include "provided.h"
+#include <iostream>
+#include <string>
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3){
+        cerr << "Usage: " << argv[0] << " <wordlist.txt> <wordlist.idx>" << endl;
+        return 2;
+    }
+    
+    WordList wl;
+    if ( ! wl.loadWordList(argv[1])){
+        cerr << "Unable to load word list file " << argv[1] << endl;
+        return 1;
+    }
+    
+    if ( ! wl.saveIndex(argv[2])){
+        cerr << "Unable to write index file " << argv[2] << endl;
+        return 1;
+    }
+    
+    return 0;
+}